@@ -1,8 +1,20 @@
-from esphome import automation
+from esphome import automation, pins
 import esphome.codegen as cg
 from esphome.components import uart
 import esphome.config_validation as cv
-from esphome.const import CONF_ID, CONF_TRIGGER_ID, CONF_URL, CONF_PIN
+from esphome.const import (
+    CONF_DATA,
+    CONF_HOST,
+    CONF_ID,
+    CONF_PAYLOAD,
+    CONF_PIN,
+    CONF_PORT,
+    CONF_PROTOCOL,
+    CONF_SIZE,
+    CONF_TRIGGER_ID,
+    CONF_URL,
+)
+from esphome.core import CORE
 
 DEPENDENCIES = ["uart"]
 CODEOWNERS = ["@christianhubmann"]
@@ -12,14 +24,75 @@ CONF_APN_USER = "apn_user"
 CONF_APN_PASSWORD = "apn_password"
 CONF_ON_HTTP_REQUEST_DONE = "on_http_request_done"
 CONF_ON_HTTP_REQUEST_FAILED = "on_http_request_failed"
+CONF_ON_HTTP_RESPONSE_CHUNK = "on_http_response_chunk"
+CONF_ON_HTTP_BINARY_RESPONSE = "on_http_binary_response"
+CONF_ON_HTTP_BINARY_CHUNK = "on_http_binary_chunk"
+CONF_ON_SOCKET_CONNECTED = "on_socket_connected"
+CONF_ON_SOCKET_DATA = "on_socket_data"
+CONF_ON_SOCKET_BINARY_DATA = "on_socket_binary_data"
+CONF_ON_SOCKET_CLOSED = "on_socket_closed"
 CONF_IDLE_SLEEP = "idle_sleep"
+CONF_DTR_PIN = "dtr_pin"
+CONF_TARGET_BAUD_RATE = "target_baud_rate"
+CONF_FLOW_CONTROL = "flow_control"
+CONF_RTS_PIN = "rts_pin"
+CONF_CTS_PIN = "cts_pin"
+CONF_BATTERY_CHECK_INTERVAL = "battery_check_interval"
+CONF_REGISTRATION_CHECK_INTERVAL = "registration_check_interval"
+CONF_SIGNAL_CHECK_INTERVAL = "signal_check_interval"
+CONF_CONTENT_TYPE = "content_type"
+CONF_BODY = "body"
+CONF_HTTP_QUEUE_SIZE = "http_queue_size"
+CONF_KEEP_BEARER_OPEN = "keep_bearer_open"
+CONF_STREAM_RESPONSE = "stream_response"
+CONF_HTTP_STATS = "http_stats"
+CONF_HTTP_KEEP_ALIVE = "http_keep_alive"
+CONF_RESPONSE_CHUNK_SIZE = "response_chunk_size"
+CONF_ADAPTIVE_TIMEOUTS = "adaptive_timeouts"
+CONF_PERSIST_TIMEOUTS = "persist_timeouts"
+CONF_OUTBOX = "outbox"
+CONF_HTTP_COALESCE = "http_coalesce"
+CONF_HTTP_MIN_INTERVAL = "http_min_interval"
+CONF_ON_RESPONSE = "on_response"
 
 sim800l_data_ns = cg.esphome_ns.namespace("sim800l_data")
 Sim800LDataComponent = sim800l_data_ns.class_("Sim800LDataComponent", cg.Component)
 
+# Each outbox slot is one flash preference of 136 bytes. The ESP8266 keeps all flash
+# preferences in 512 bytes, so it has room for 2 slots next to the other components.
+OUTBOX_DEFAULT_SIZE = 8
+OUTBOX_MAX_SIZE = 64
+OUTBOX_MAX_SIZE_ESP8266 = 2
+
+
+def validate_outbox_size(config):
+    max_size = OUTBOX_MAX_SIZE_ESP8266 if CORE.is_esp8266 else OUTBOX_MAX_SIZE
+    if CONF_SIZE not in config:
+        config[CONF_SIZE] = min(OUTBOX_DEFAULT_SIZE, max_size)
+    elif config[CONF_SIZE] > max_size:
+        raise cv.Invalid(
+            f"The outbox can have at most {max_size} entries on this platform", path=[CONF_SIZE]
+        )
+    return config
+
+
+def validate_persist_timeouts(config):
+    if config[CONF_PERSIST_TIMEOUTS] and not config[CONF_ADAPTIVE_TIMEOUTS]:
+        raise cv.Invalid(
+            f"{CONF_PERSIST_TIMEOUTS} requires {CONF_ADAPTIVE_TIMEOUTS}", path=[CONF_PERSIST_TIMEOUTS]
+        )
+    return config
+
+
+# Store a payload in the outbox, to be sent when the network is available.
+OutboxAddAction = sim800l_data_ns.class_("OutboxAddAction", automation.Action)
+
 # Send a HTTP GET request over GPRS.
 HttpGetAction = sim800l_data_ns.class_("HttpGetAction", automation.Action)
 
+# Send a HTTP POST request over GPRS.
+HttpPostAction = sim800l_data_ns.class_("HttpPostAction", automation.Action)
+
 # This automation triggers when the HTTP request was sent successfully.
 # This does not mean that the remote server returned a success status code.
 HttpRequestDoneTrigger = sim800l_data_ns.class_(
@@ -27,14 +100,83 @@ HttpRequestDoneTrigger = sim800l_data_ns.class_(
     automation.Trigger.template(cg.uint16, cg.std_string_ref),
 )
 
+# This automation triggers for each chunk of the response body when stream_response is enabled.
+HttpResponseChunkTrigger = sim800l_data_ns.class_(
+    "HttpResponseChunkTrigger",
+    automation.Trigger.template(cg.uint32, cg.std_string_ref),
+)
+
+# These automations get the response body or chunk unchanged, including \0 bytes.
+HttpBinaryResponseTrigger = sim800l_data_ns.class_(
+    "HttpBinaryResponseTrigger",
+    automation.Trigger.template(cg.uint16, cg.std_vector.template(cg.uint8)),
+)
+
+HttpBinaryChunkTrigger = sim800l_data_ns.class_(
+    "HttpBinaryChunkTrigger",
+    automation.Trigger.template(cg.uint32, cg.std_vector.template(cg.uint8)),
+)
+
 # This automation triggers when the HTTP request could not be sent.
 HttpRequestFailedTrigger = sim800l_data_ns.class_(
     "HttpRequestFailedTrigger",
     automation.Trigger.template(),
 )
 
+# Open a TCP or UDP socket with the IP stack of the module.
+SocketConnectAction = sim800l_data_ns.class_("SocketConnectAction", automation.Action)
+
+# Send data over the open socket.
+SocketSendAction = sim800l_data_ns.class_("SocketSendAction", automation.Action)
+
+# Close the open socket.
+SocketCloseAction = sim800l_data_ns.class_("SocketCloseAction", automation.Action)
+
+HttpCoalesce = sim800l_data_ns.enum("HttpCoalesce", is_class=True)
+HTTP_COALESCE_MODES = {
+    "NONE": HttpCoalesce.NONE,
+    "LATEST": HttpCoalesce.LATEST,
+    "MERGE_QUERY": HttpCoalesce.MERGE_QUERY,
+}
+
+# This automation triggers with the result of one http_get action.
+HttpResponseTrigger = sim800l_data_ns.class_(
+    "HttpResponseTrigger",
+    automation.Trigger.template(cg.uint16, cg.std_string_ref),
+)
+
+SocketProtocol = sim800l_data_ns.enum("SocketProtocol", is_class=True)
+SOCKET_PROTOCOLS = {
+    "TCP": SocketProtocol.TCP,
+    "UDP": SocketProtocol.UDP,
+}
+
+# This automation triggers when the socket is connected.
+SocketConnectedTrigger = sim800l_data_ns.class_(
+    "SocketConnectedTrigger",
+    automation.Trigger.template(),
+)
+
+# This automation triggers for each block of data received on the socket.
+SocketDataTrigger = sim800l_data_ns.class_(
+    "SocketDataTrigger",
+    automation.Trigger.template(cg.std_string_ref),
+)
+
+# This automation gets the data received on the socket unchanged, including \0 bytes.
+SocketBinaryDataTrigger = sim800l_data_ns.class_(
+    "SocketBinaryDataTrigger",
+    automation.Trigger.template(cg.std_vector.template(cg.uint8)),
+)
+
+# This automation triggers when the socket was closed, was lost or could not be connected.
+SocketClosedTrigger = sim800l_data_ns.class_(
+    "SocketClosedTrigger",
+    automation.Trigger.template(),
+)
+
 
-CONFIG_SCHEMA = (
+CONFIG_SCHEMA = cv.All(
     cv.Schema(
         {
             cv.GenerateID(): cv.declare_id(Sim800LDataComponent),
@@ -43,20 +185,92 @@ CONFIG_SCHEMA = (
             cv.Optional(CONF_APN_USER): cv.All(cv.string, cv.Length(max=32)),
             cv.Optional(CONF_APN_PASSWORD): cv.All(cv.string, cv.Length(max=32)),
             cv.Optional(CONF_IDLE_SLEEP, default=False): cv.boolean,
+            cv.Optional(CONF_DTR_PIN): pins.gpio_output_pin_schema,
+            cv.Optional(CONF_FLOW_CONTROL): cv.All(
+                cv.only_on_esp32,
+                cv.Schema(
+                    {
+                        cv.Required(CONF_RTS_PIN): pins.internal_gpio_output_pin_number,
+                        cv.Required(CONF_CTS_PIN): pins.internal_gpio_input_pin_number,
+                    }
+                ),
+            ),
+            cv.Optional(CONF_TARGET_BAUD_RATE): cv.one_of(
+                9600, 19200, 38400, 57600, 115200, 230400, 460800, int=True
+            ),
+            cv.Optional(CONF_BATTERY_CHECK_INTERVAL): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_REGISTRATION_CHECK_INTERVAL): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_SIGNAL_CHECK_INTERVAL): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_HTTP_QUEUE_SIZE, default=5): cv.int_range(min=1, max=32),
+            cv.Optional(CONF_KEEP_BEARER_OPEN, default="0s"): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_HTTP_COALESCE, default="NONE"): cv.enum(HTTP_COALESCE_MODES, upper=True),
+            cv.Optional(CONF_HTTP_MIN_INTERVAL, default="0s"): cv.positive_time_period_milliseconds,
+            cv.Optional(CONF_STREAM_RESPONSE, default=False): cv.boolean,
+            cv.Optional(CONF_HTTP_STATS, default=False): cv.boolean,
+            cv.Optional(CONF_HTTP_KEEP_ALIVE, default=False): cv.boolean,
+            cv.Optional(CONF_RESPONSE_CHUNK_SIZE, default=512): cv.int_range(min=16, max=4096),
+            cv.Optional(CONF_OUTBOX): cv.All(
+                cv.Schema(
+                    {
+                        cv.Required(CONF_URL): cv.string_strict,
+                        cv.Optional(CONF_CONTENT_TYPE, default="text/plain"): cv.string_strict,
+                        cv.Optional(CONF_SIZE): cv.int_range(min=1, max=OUTBOX_MAX_SIZE),
+                    }
+                ),
+                validate_outbox_size,
+            ),
+            cv.Optional(CONF_ADAPTIVE_TIMEOUTS, default=False): cv.boolean,
+            cv.Optional(CONF_PERSIST_TIMEOUTS, default=False): cv.boolean,
             cv.Optional(CONF_ON_HTTP_REQUEST_DONE): automation.validate_automation(
                 {
                     cv.GenerateID(CONF_TRIGGER_ID): cv.declare_id(HttpRequestDoneTrigger),
                 }
             ),
+            cv.Optional(CONF_ON_HTTP_RESPONSE_CHUNK): automation.validate_automation(
+                {
+                    cv.GenerateID(CONF_TRIGGER_ID): cv.declare_id(HttpResponseChunkTrigger),
+                }
+            ),
+            cv.Optional(CONF_ON_HTTP_BINARY_RESPONSE): automation.validate_automation(
+                {
+                    cv.GenerateID(CONF_TRIGGER_ID): cv.declare_id(HttpBinaryResponseTrigger),
+                }
+            ),
+            cv.Optional(CONF_ON_HTTP_BINARY_CHUNK): automation.validate_automation(
+                {
+                    cv.GenerateID(CONF_TRIGGER_ID): cv.declare_id(HttpBinaryChunkTrigger),
+                }
+            ),
             cv.Optional(CONF_ON_HTTP_REQUEST_FAILED): automation.validate_automation(
                 {
                     cv.GenerateID(CONF_TRIGGER_ID): cv.declare_id(HttpRequestFailedTrigger),
                 }
             ),
+            cv.Optional(CONF_ON_SOCKET_CONNECTED): automation.validate_automation(
+                {
+                    cv.GenerateID(CONF_TRIGGER_ID): cv.declare_id(SocketConnectedTrigger),
+                }
+            ),
+            cv.Optional(CONF_ON_SOCKET_DATA): automation.validate_automation(
+                {
+                    cv.GenerateID(CONF_TRIGGER_ID): cv.declare_id(SocketDataTrigger),
+                }
+            ),
+            cv.Optional(CONF_ON_SOCKET_BINARY_DATA): automation.validate_automation(
+                {
+                    cv.GenerateID(CONF_TRIGGER_ID): cv.declare_id(SocketBinaryDataTrigger),
+                }
+            ),
+            cv.Optional(CONF_ON_SOCKET_CLOSED): automation.validate_automation(
+                {
+                    cv.GenerateID(CONF_TRIGGER_ID): cv.declare_id(SocketClosedTrigger),
+                }
+            ),
         }
     )
     .extend(cv.polling_component_schema("10s"))
-    .extend(uart.UART_DEVICE_SCHEMA)
+    .extend(uart.UART_DEVICE_SCHEMA),
+    validate_persist_timeouts,
 )
 
 FINAL_VALIDATE_SCHEMA = uart.final_validate_device_schema(
@@ -81,18 +295,83 @@ async def to_code(config):
         cg.add(var.set_apn_password(config[CONF_APN_PASSWORD]))
     if CONF_IDLE_SLEEP in config:
         cg.add(var.set_idle_sleep(config[CONF_IDLE_SLEEP]))
+    if CONF_DTR_PIN in config:
+        pin = await cg.gpio_pin_expression(config[CONF_DTR_PIN])
+        cg.add(var.set_dtr_pin(pin))
+    if CONF_FLOW_CONTROL in config:
+        flow_control = config[CONF_FLOW_CONTROL]
+        cg.add(var.set_flow_control_pins(flow_control[CONF_RTS_PIN], flow_control[CONF_CTS_PIN]))
+    if CONF_TARGET_BAUD_RATE in config:
+        cg.add(var.set_target_baud_rate(config[CONF_TARGET_BAUD_RATE]))
+    if CONF_BATTERY_CHECK_INTERVAL in config:
+        cg.add(var.set_battery_check_interval(config[CONF_BATTERY_CHECK_INTERVAL]))
+    if CONF_REGISTRATION_CHECK_INTERVAL in config:
+        cg.add(var.set_registration_check_interval(config[CONF_REGISTRATION_CHECK_INTERVAL]))
+    if CONF_SIGNAL_CHECK_INTERVAL in config:
+        cg.add(var.set_signal_check_interval(config[CONF_SIGNAL_CHECK_INTERVAL]))
+    if CONF_HTTP_QUEUE_SIZE in config:
+        cg.add(var.set_http_queue_size(config[CONF_HTTP_QUEUE_SIZE]))
+    if CONF_KEEP_BEARER_OPEN in config:
+        cg.add(var.set_keep_bearer_open(config[CONF_KEEP_BEARER_OPEN]))
+    if CONF_HTTP_COALESCE in config:
+        cg.add(var.set_http_coalesce(config[CONF_HTTP_COALESCE]))
+    if CONF_HTTP_MIN_INTERVAL in config:
+        cg.add(var.set_http_min_interval(config[CONF_HTTP_MIN_INTERVAL]))
+    if CONF_HTTP_STATS in config:
+        cg.add(var.set_http_stats(config[CONF_HTTP_STATS]))
+    if CONF_HTTP_KEEP_ALIVE in config:
+        cg.add(var.set_http_keep_alive(config[CONF_HTTP_KEEP_ALIVE]))
+    if CONF_STREAM_RESPONSE in config:
+        cg.add(var.set_stream_response(config[CONF_STREAM_RESPONSE]))
+    if CONF_RESPONSE_CHUNK_SIZE in config:
+        cg.add(var.set_response_chunk_size(config[CONF_RESPONSE_CHUNK_SIZE]))
+    if CONF_ADAPTIVE_TIMEOUTS in config:
+        cg.add(var.set_adaptive_timeouts(config[CONF_ADAPTIVE_TIMEOUTS]))
+    if CONF_PERSIST_TIMEOUTS in config:
+        cg.add(var.set_persist_timeouts(config[CONF_PERSIST_TIMEOUTS]))
+    if CONF_OUTBOX in config:
+        outbox = config[CONF_OUTBOX]
+        cg.add(var.set_outbox(outbox[CONF_URL], outbox[CONF_CONTENT_TYPE], outbox[CONF_SIZE]))
     for conf in config.get(CONF_ON_HTTP_REQUEST_DONE, []):
         trigger = cg.new_Pvariable(conf[CONF_TRIGGER_ID], var)
         await automation.build_automation(trigger, [(cg.uint16, "status_code"), (cg.std_string_ref, "response_body")], conf)
+    for conf in config.get(CONF_ON_HTTP_RESPONSE_CHUNK, []):
+        trigger = cg.new_Pvariable(conf[CONF_TRIGGER_ID], var)
+        await automation.build_automation(trigger, [(cg.uint32, "offset"), (cg.std_string_ref, "chunk")], conf)
+    for conf in config.get(CONF_ON_HTTP_BINARY_RESPONSE, []):
+        trigger = cg.new_Pvariable(conf[CONF_TRIGGER_ID], var)
+        await automation.build_automation(
+            trigger, [(cg.uint16, "status_code"), (cg.std_vector.template(cg.uint8), "response_body")], conf
+        )
+    for conf in config.get(CONF_ON_HTTP_BINARY_CHUNK, []):
+        trigger = cg.new_Pvariable(conf[CONF_TRIGGER_ID], var)
+        await automation.build_automation(trigger, [(cg.uint32, "offset"), (cg.std_vector.template(cg.uint8), "chunk")], conf)
     for conf in config.get(CONF_ON_HTTP_REQUEST_FAILED, []):
         trigger = cg.new_Pvariable(conf[CONF_TRIGGER_ID], var)
         await automation.build_automation(trigger, [], conf)
+    for conf in config.get(CONF_ON_SOCKET_CONNECTED, []):
+        trigger = cg.new_Pvariable(conf[CONF_TRIGGER_ID], var)
+        await automation.build_automation(trigger, [], conf)
+    for conf in config.get(CONF_ON_SOCKET_DATA, []):
+        trigger = cg.new_Pvariable(conf[CONF_TRIGGER_ID], var)
+        await automation.build_automation(trigger, [(cg.std_string_ref, "data")], conf)
+    for conf in config.get(CONF_ON_SOCKET_BINARY_DATA, []):
+        trigger = cg.new_Pvariable(conf[CONF_TRIGGER_ID], var)
+        await automation.build_automation(trigger, [(cg.std_vector.template(cg.uint8), "data")], conf)
+    for conf in config.get(CONF_ON_SOCKET_CLOSED, []):
+        trigger = cg.new_Pvariable(conf[CONF_TRIGGER_ID], var)
+        await automation.build_automation(trigger, [], conf)
 
 
 HTTP_GET_SCHEMA = cv.Schema(
     {
         cv.GenerateID(): cv.use_id(Sim800LDataComponent),
         cv.Required(CONF_URL): cv.templatable(cv.string_strict),
+        cv.Optional(CONF_ON_RESPONSE): automation.validate_automation(
+            {
+                cv.GenerateID(CONF_TRIGGER_ID): cv.declare_id(HttpResponseTrigger),
+            }
+        ),
     }
 )
 
@@ -103,4 +382,100 @@ async def http_get_to_code(config, action_id, template_arg, args):
     var = cg.new_Pvariable(action_id, template_arg, paren)
     template_ = await cg.templatable(config[CONF_URL], args, cg.std_string)
     cg.add(var.set_url(template_))
+    for conf in config.get(CONF_ON_RESPONSE, []):
+        trigger = cg.new_Pvariable(conf[CONF_TRIGGER_ID])
+        cg.add(var.add_response_trigger(trigger))
+        await automation.build_automation(trigger, [(cg.uint16, "status_code"), (cg.std_string_ref, "response_body")], conf)
     return var
+
+
+HTTP_POST_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(): cv.use_id(Sim800LDataComponent),
+        cv.Required(CONF_URL): cv.templatable(cv.string_strict),
+        cv.Optional(CONF_CONTENT_TYPE, default="text/plain"): cv.templatable(cv.string_strict),
+        cv.Required(CONF_BODY): cv.templatable(cv.string),
+    }
+)
+
+
+@automation.register_action("sim800l_data.http_post", HttpPostAction, HTTP_POST_SCHEMA)
+async def http_post_to_code(config, action_id, template_arg, args):
+    paren = await cg.get_variable(config[CONF_ID])
+    var = cg.new_Pvariable(action_id, template_arg, paren)
+    template_ = await cg.templatable(config[CONF_URL], args, cg.std_string)
+    cg.add(var.set_url(template_))
+    template_ = await cg.templatable(config[CONF_CONTENT_TYPE], args, cg.std_string)
+    cg.add(var.set_content_type(template_))
+    template_ = await cg.templatable(config[CONF_BODY], args, cg.std_string)
+    cg.add(var.set_body(template_))
+    return var
+
+
+OUTBOX_ADD_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(): cv.use_id(Sim800LDataComponent),
+        cv.Required(CONF_PAYLOAD): cv.templatable(cv.string),
+    }
+)
+
+
+@automation.register_action("sim800l_data.outbox_add", OutboxAddAction, OUTBOX_ADD_SCHEMA)
+async def outbox_add_to_code(config, action_id, template_arg, args):
+    paren = await cg.get_variable(config[CONF_ID])
+    var = cg.new_Pvariable(action_id, template_arg, paren)
+    template_ = await cg.templatable(config[CONF_PAYLOAD], args, cg.std_string)
+    cg.add(var.set_payload(template_))
+    return var
+
+
+SOCKET_CONNECT_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(): cv.use_id(Sim800LDataComponent),
+        cv.Optional(CONF_PROTOCOL, default="TCP"): cv.enum(SOCKET_PROTOCOLS, upper=True),
+        cv.Required(CONF_HOST): cv.templatable(cv.string_strict),
+        cv.Required(CONF_PORT): cv.templatable(cv.port),
+    }
+)
+
+
+@automation.register_action("sim800l_data.socket_connect", SocketConnectAction, SOCKET_CONNECT_SCHEMA)
+async def socket_connect_to_code(config, action_id, template_arg, args):
+    paren = await cg.get_variable(config[CONF_ID])
+    var = cg.new_Pvariable(action_id, template_arg, paren)
+    cg.add(var.set_protocol(config[CONF_PROTOCOL]))
+    template_ = await cg.templatable(config[CONF_HOST], args, cg.std_string)
+    cg.add(var.set_host(template_))
+    template_ = await cg.templatable(config[CONF_PORT], args, cg.uint16)
+    cg.add(var.set_port(template_))
+    return var
+
+
+SOCKET_SEND_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(): cv.use_id(Sim800LDataComponent),
+        cv.Required(CONF_DATA): cv.templatable(cv.string),
+    }
+)
+
+
+@automation.register_action("sim800l_data.socket_send", SocketSendAction, SOCKET_SEND_SCHEMA)
+async def socket_send_to_code(config, action_id, template_arg, args):
+    paren = await cg.get_variable(config[CONF_ID])
+    var = cg.new_Pvariable(action_id, template_arg, paren)
+    template_ = await cg.templatable(config[CONF_DATA], args, cg.std_string)
+    cg.add(var.set_data(template_))
+    return var
+
+
+SOCKET_CLOSE_SCHEMA = cv.Schema(
+    {
+        cv.GenerateID(): cv.use_id(Sim800LDataComponent),
+    }
+)
+
+
+@automation.register_action("sim800l_data.socket_close", SocketCloseAction, SOCKET_CLOSE_SCHEMA)
+async def socket_close_to_code(config, action_id, template_arg, args):
+    paren = await cg.get_variable(config[CONF_ID])
+    return cg.new_Pvariable(action_id, template_arg, paren)
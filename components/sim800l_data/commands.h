@@ -0,0 +1,195 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#include "constants.h"
+
+namespace esphome {
+namespace sim800l_data {
+
+enum class CommandId : uint8_t {
+  AT,
+  AT_SYNC,
+  DISABLE_ECHO,
+  SET_BAUD_RATE,
+  ENABLE_FLOW_CONTROL,
+  DISABLE_SLEEP,
+  ENABLE_SLEEP,
+  ENABLE_DTR_SLEEP,
+  CHECK_BATTERY,
+  CHECK_PIN,
+  ENTER_PIN,
+  SET_CONTYPE_GPRS,
+  SET_APN,
+  SET_APN_USER,
+  SET_APN_PWD,
+  ENABLE_REGISTRATION_URC,
+  CHECK_REGISTRATION,
+  CHECK_SIGNAL_QUALITY,
+  BEARER_STATUS,
+  BEARER_OPEN,
+  BEARER_CLOSE,
+  HTTP_INIT,
+  HTTP_SET_BEARER,
+  HTTP_SET_SSL,
+  HTTP_SET_URL,
+  HTTP_SET_CONTENT,
+  HTTP_DATA,
+  HTTP_ACTION,
+  HTTP_READ,
+  HTTP_READ_RANGE,
+  HTTP_TERM,
+  SOCKET_SHUT,
+  SOCKET_MANUAL_RECEIVE,
+  SOCKET_SET_APN,
+  SOCKET_BRING_UP,
+  SOCKET_GET_IP,
+  SOCKET_CONNECT,
+  SOCKET_SEND,
+  SOCKET_SEND_DATA,
+  SOCKET_RECEIVE,
+  SOCKET_CLOSE,
+  COUNT,
+};
+
+// What a command returns before it is complete.
+enum class ResponseKind : uint8_t {
+  OK_ONLY,   // OK
+  RESPONSE,  // a response line starting with the prefix, then OK
+  URC,       // OK, then a URC starting with the prefix
+  DATA,      // a response line starting with the prefix, then data, then OK
+  PROMPT,    // the prefix, e.g. DOWNLOAD, or "> " which is not followed by a line break
+  FINAL,     // a line starting with the prefix instead of OK, e.g. SHUT OK
+};
+
+// Static description of an AT command. The command is sent as
+// "AT" + text + argument + suffix, so no string has to be built for it.
+struct AtCommand {
+  constexpr AtCommand(CommandId id, const char *text, const char *suffix, ResponseKind kind, const char *prefix,
+                      uint32_t timeout = DEFAULT_COMMAND_TIMEOUT, uint32_t urc_timeout = DEFAULT_URC_TIMEOUT)
+      : id(id),
+        text(text),
+        suffix(suffix),
+        kind(kind),
+        prefix(prefix),
+        prefix_length(prefix == nullptr ? 0 : std::char_traits<char>::length(prefix)),
+        timeout(timeout),
+        urc_timeout(urc_timeout) {}
+
+  CommandId id;
+  const char *text;
+  const char *suffix;
+  ResponseKind kind;
+  const char *prefix;
+  uint8_t prefix_length;
+  uint32_t timeout;
+  uint32_t urc_timeout;
+
+  // Returns whether the line is a response or URC of this command.
+  bool matches(std::string_view line) const {
+    return this->prefix_length > 0 &&
+           line.substr(0, this->prefix_length) == std::string_view(this->prefix, this->prefix_length);
+  }
+
+  // The timeout that limits the whole command: the URC timeout for URC commands, else the command timeout.
+  constexpr uint32_t max_runtime() const {
+    return this->kind == ResponseKind::URC || this->kind == ResponseKind::FINAL ? this->urc_timeout : this->timeout;
+  }
+};
+
+// clang-format off
+static constexpr AtCommand COMMANDS[] = {
+    {CommandId::AT,                   "",                             nullptr, ResponseKind::OK_ONLY,  nullptr},
+    {CommandId::AT_SYNC,              "",                             nullptr, ResponseKind::OK_ONLY,  nullptr,
+     AT_SYNC_TIMEOUT},
+    {CommandId::DISABLE_ECHO,         "E0",                           nullptr, ResponseKind::OK_ONLY,  nullptr},
+    {CommandId::SET_BAUD_RATE,        "+IPR=",                        nullptr, ResponseKind::OK_ONLY,  nullptr},
+    {CommandId::ENABLE_FLOW_CONTROL,  "+IFC=2,2",                     nullptr, ResponseKind::OK_ONLY,  nullptr},
+    {CommandId::DISABLE_SLEEP,        "+CSCLK=0",                     nullptr, ResponseKind::OK_ONLY,  nullptr},
+    {CommandId::ENABLE_SLEEP,         "+CSCLK=2",                     nullptr, ResponseKind::OK_ONLY,  nullptr},
+    {CommandId::ENABLE_DTR_SLEEP,     "+CSCLK=1",                     nullptr, ResponseKind::OK_ONLY,  nullptr},
+    {CommandId::CHECK_BATTERY,        "+CBC",                         nullptr, ResponseKind::RESPONSE, "+CBC:"},
+    {CommandId::CHECK_PIN,            "+CPIN?",                       nullptr, ResponseKind::RESPONSE, "+CPIN:",
+     CHECK_PIN_TIMEOUT},
+    {CommandId::ENTER_PIN,            "+CPIN=\"",                     "\"",    ResponseKind::URC,      "+CPIN:",
+     CHECK_PIN_TIMEOUT, CHECK_PIN_TIMEOUT},
+    {CommandId::SET_CONTYPE_GPRS,     "+SAPBR=3,1,\"CONTYPE\",\"GPRS\"", nullptr, ResponseKind::OK_ONLY, nullptr},
+    {CommandId::SET_APN,              "+SAPBR=3,1,\"APN\",\"",        "\"",    ResponseKind::OK_ONLY,  nullptr},
+    {CommandId::SET_APN_USER,         "+SAPBR=3,1,\"USER\",\"",       "\"",    ResponseKind::OK_ONLY,  nullptr},
+    {CommandId::SET_APN_PWD,          "+SAPBR=3,1,\"PWD\",\"",        "\"",    ResponseKind::OK_ONLY,  nullptr},
+    {CommandId::ENABLE_REGISTRATION_URC, "+CREG=1",                   nullptr, ResponseKind::OK_ONLY,  nullptr},
+    {CommandId::CHECK_REGISTRATION,   "+CREG?",                       nullptr, ResponseKind::RESPONSE, "+CREG:"},
+    {CommandId::CHECK_SIGNAL_QUALITY, "+CSQ",                         nullptr, ResponseKind::RESPONSE, "+CSQ:"},
+    {CommandId::BEARER_STATUS,        "+SAPBR=2,1",                   nullptr, ResponseKind::RESPONSE, "+SAPBR:"},
+    {CommandId::BEARER_OPEN,          "+SAPBR=1,1",                   nullptr, ResponseKind::OK_ONLY,  nullptr,
+     BEARER_OPEN_TIMEOUT},
+    {CommandId::BEARER_CLOSE,         "+SAPBR=0,1",                   nullptr, ResponseKind::OK_ONLY,  nullptr,
+     BEARER_CLOSE_TIMEOUT},
+    {CommandId::HTTP_INIT,            "+HTTPINIT",                    nullptr, ResponseKind::OK_ONLY,  nullptr},
+    {CommandId::HTTP_SET_BEARER,      "+HTTPPARA=\"CID\",1",          nullptr, ResponseKind::OK_ONLY,  nullptr},
+    {CommandId::HTTP_SET_SSL,         "+HTTPSSL=",                    nullptr, ResponseKind::OK_ONLY,  nullptr},
+    {CommandId::HTTP_SET_URL,         "+HTTPPARA=\"URL\",\"",         "\"",    ResponseKind::OK_ONLY,  nullptr},
+    {CommandId::HTTP_SET_CONTENT,     "+HTTPPARA=\"CONTENT\",\"",     "\"",    ResponseKind::OK_ONLY,  nullptr},
+    {CommandId::HTTP_DATA,            "+HTTPDATA=",                   nullptr, ResponseKind::PROMPT,   "DOWNLOAD"},
+    {CommandId::HTTP_ACTION,          "+HTTPACTION=",                 nullptr, ResponseKind::URC,      "+HTTPACTION:",
+     HTTP_ACTION_TIMEOUT},
+    {CommandId::HTTP_READ,            "+HTTPREAD",                    nullptr, ResponseKind::DATA,     "+HTTPREAD:"},
+    {CommandId::HTTP_READ_RANGE,      "+HTTPREAD=",                   nullptr, ResponseKind::DATA,     "+HTTPREAD:"},
+    {CommandId::HTTP_TERM,            "+HTTPTERM",                    nullptr, ResponseKind::OK_ONLY,  nullptr},
+    {CommandId::SOCKET_SHUT,          "+CIPSHUT",                     nullptr, ResponseKind::FINAL,    "SHUT OK",
+     DEFAULT_COMMAND_TIMEOUT, SOCKET_SHUT_TIMEOUT},
+    {CommandId::SOCKET_MANUAL_RECEIVE, "+CIPRXGET=1",                 nullptr, ResponseKind::OK_ONLY,  nullptr},
+    {CommandId::SOCKET_SET_APN,       "+CSTT=\"",                     "\"",    ResponseKind::OK_ONLY,  nullptr},
+    {CommandId::SOCKET_BRING_UP,      "+CIICR",                       nullptr, ResponseKind::OK_ONLY,  nullptr,
+     BEARER_OPEN_TIMEOUT},
+    {CommandId::SOCKET_GET_IP,        "+CIFSREX",                     nullptr, ResponseKind::RESPONSE, "+CIFSREX:"},
+    {CommandId::SOCKET_CONNECT,       "+CIPSTART=",                   nullptr, ResponseKind::URC,      "CONNECT OK",
+     DEFAULT_COMMAND_TIMEOUT, SOCKET_CONNECT_TIMEOUT},
+    {CommandId::SOCKET_SEND,          "+CIPSEND=",                    nullptr, ResponseKind::PROMPT,   ">"},
+    {CommandId::SOCKET_SEND_DATA,     "",                             nullptr, ResponseKind::FINAL,    "SEND OK"},
+    {CommandId::SOCKET_RECEIVE,       "+CIPRXGET=2,",                 nullptr, ResponseKind::DATA,     "+CIPRXGET: 2,"},
+    {CommandId::SOCKET_CLOSE,         "+CIPCLOSE",                    nullptr, ResponseKind::FINAL,    "CLOSE OK"},
+};
+// clang-format on
+
+static constexpr bool commands_in_order() {
+  for (size_t i = 0; i < sizeof(COMMANDS) / sizeof(COMMANDS[0]); i++) {
+    if (COMMANDS[i].id != static_cast<CommandId>(i)) {
+      return false;
+    }
+  }
+  return sizeof(COMMANDS) / sizeof(COMMANDS[0]) == static_cast<size_t>(CommandId::COUNT);
+}
+static_assert(commands_in_order(), "COMMANDS must contain every CommandId in order");
+
+// Returns the descriptor of a command.
+constexpr const AtCommand &at_command(CommandId id) { return COMMANDS[static_cast<uint8_t>(id)]; }
+
+// Whether the timeout of a command adapts to its latency. Data commands take longer the more data
+// they return, and timeouts up to MIN_ADAPTIVE_TIMEOUT can't be lowered.
+constexpr bool has_adaptive_timeout(const AtCommand &command) {
+  return command.kind != ResponseKind::DATA && command.max_runtime() > MIN_ADAPTIVE_TIMEOUT;
+}
+
+static const uint8_t NO_ADAPTIVE_TIMEOUT = 0xFF;
+
+// Index of each command in the latency estimates, or NO_ADAPTIVE_TIMEOUT.
+struct AdaptiveTimeoutIndex {
+  uint8_t index[static_cast<size_t>(CommandId::COUNT)];
+  uint8_t count;
+};
+
+constexpr AdaptiveTimeoutIndex make_adaptive_timeout_index() {
+  AdaptiveTimeoutIndex result{};
+  for (size_t i = 0; i < static_cast<size_t>(CommandId::COUNT); i++) {
+    result.index[i] = has_adaptive_timeout(COMMANDS[i]) ? result.count++ : NO_ADAPTIVE_TIMEOUT;
+  }
+  return result;
+}
+
+static constexpr AdaptiveTimeoutIndex ADAPTIVE_TIMEOUT_INDEX = make_adaptive_timeout_index();
+static constexpr size_t ADAPTIVE_COMMAND_COUNT = ADAPTIVE_TIMEOUT_INDEX.count;
+
+}  // namespace sim800l_data
+}  // namespace esphome
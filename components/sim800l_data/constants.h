@@ -6,18 +6,61 @@ namespace sim800l_data {
 static const char *const TAG = "sim800l_data";
 
 static const uint16_t MAX_READ_BUFFER_SIZE = 512;
-static const uint16_t SETUP_WAIT = 1000;
+static const uint16_t RX_BUFFER_SIZE = 1024;
+static const uint16_t RESPONSE_BUFFER_SIZE = 64;
+static const uint8_t MAX_COMBINED_COMMANDS = 3;
 static const uint16_t DEFAULT_COMMAND_TIMEOUT = 1000;
 static const uint16_t DEFAULT_URC_TIMEOUT = 30000;
 static const uint16_t CHECK_PIN_TIMEOUT = 5000;      // according to Command Manual
+// Timeout of the AT that syncs with the module in INIT. It is repeated until the module has
+// started and detected the baud rate, so a short timeout answers soon after it is ready.
+static const uint16_t AT_SYNC_TIMEOUT = 250;
+// While waiting for the SIM or the registration after boot, the URCs move on as soon as they
+// are reported. These are only polled this often, in case a URC is missed.
+static const uint16_t SIM_READY_POLL_INTERVAL = 2000;
+static const uint16_t REGISTRATION_POLL_INTERVAL = 10000;
 static const uint32_t BEARER_OPEN_TIMEOUT = 85000;   // according to Command Manual
 static const uint16_t BEARER_CLOSE_TIMEOUT = 65000;  // according to Command Manual
 static const uint16_t HTTP_ACTION_TIMEOUT = 5000;    // according to Command Manual
+static const uint32_t SOCKET_CONNECT_TIMEOUT = 75000;  // according to Command Manual
+static const uint16_t SOCKET_SHUT_TIMEOUT = 65000;     // according to Command Manual
+// Maximum length of one AT+CIPSEND.
+static const uint16_t SOCKET_MAX_SEND_SIZE = 1460;
+// Bytes fetched with one AT+CIPRXGET=2.
+static const uint16_t SOCKET_RECEIVE_SIZE = 512;
+// Number of socket_send() payloads that can wait to be sent.
+static const uint8_t SOCKET_TX_QUEUE_SIZE = 4;
 static const uint16_t MAX_HTTP_RESPONSE_SIZE = 10240;
-static const uint16_t NOT_REGISTERED_WAIT = 2000;
+static const uint16_t DEFAULT_RESPONSE_CHUNK_SIZE = 512;
+static const uint16_t HTTP_BODY_CHUNK_SIZE = 128;
+static const uint16_t HTTP_DATA_INPUT_TIMEOUT = 10000;
+static const uint8_t DEFAULT_HTTP_QUEUE_SIZE = 5;
+// Status checks are deferred while HTTP or socket traffic is pending, but at most this many intervals.
+static const uint8_t CHECK_DEADLINE_INTERVALS = 2;
+// Number of endpoints whose last request time is kept for http_min_interval.
+static const uint8_t MAX_TRACKED_ENDPOINTS = 8;
+// Maximum length of one outbox payload. Each entry takes this plus 8 bytes of flash.
+static const uint16_t OUTBOX_ENTRY_SIZE = 128;
+// Wait after a failed outbox flush before it is tried again, unless the registration comes back.
+static const uint32_t OUTBOX_RETRY_INTERVAL = 60000;
+// Adaptive timeouts are only used once a command has succeeded this many times.
+static const uint16_t ADAPTIVE_TIMEOUT_MIN_SAMPLES = 8;
+// Lower limit of adaptive timeouts, to not fail on a single slow response.
+static const uint32_t MIN_ADAPTIVE_TIMEOUT = 2000;
+// Save the latency estimates at most this often, to spare the flash.
+static const uint32_t TIMEOUT_SAVE_INTERVAL = 3600000;
+// Upper bounds (ms) of the latency histogram buckets. The last bucket takes everything above.
+static const uint32_t LATENCY_BUCKET_BOUNDS[] = {100, 500, 2000, 10000, 30000};
+static const size_t LATENCY_BUCKET_COUNT = sizeof(LATENCY_BUCKET_BOUNDS) / sizeof(LATENCY_BUCKET_BOUNDS[0]) + 1;
 
 // The Command Manual recommends to wait 100ms after AT when sleep is enabled
 static const uint16_t AT_SLEEP_WAIT = 100;
+// The serial port is active again about 50ms after DTR was pulled low, according to the Hardware Design
+static const uint16_t DTR_WAKE_WAIT = 50;
+// RX FIFO level at which the ESP deasserts RTS when hardware flow control is enabled.
+static const uint8_t FLOW_CONTROL_RX_THRESHOLD = 100;
+// Wait after changing the baud rate before the new rate is checked.
+static const uint16_t BAUD_RATE_SWITCH_WAIT = 100;
 
 // How long to wait after errors that can't be resolved.
 // Used to not spam the log with errors.
@@ -31,6 +74,23 @@ static const char *const ERROR = "ERROR";
 static const char *const READY = "READY";
 static const char *const SIM_PIN = "SIM PIN";
 static const char *const SIM_PUK = "SIM PUK";
+static const char *const NOT_READY = "NOT READY";
+static const char *const CONNECT_FAIL = "CONNECT FAIL";
+static const char *const SEND_FAIL = "SEND FAIL";
+
+// Unsolicited result codes
+static const char *const URC_REGISTRATION = "+CREG:";
+static const char *const URC_BEARER_DEACT = "+SAPBR 1: DEACT";
+static const char *const URC_READY = "RDY";
+static const char *const URC_UNDER_VOLTAGE = "UNDER-VOLTAGE";
+static const char *const URC_OVER_VOLTAGE = "OVER-VOLTAGE";
+static const char *const URC_CALL_READY = "Call Ready";
+static const char *const URC_SMS_READY = "SMS Ready";
+static const char *const URC_PIN_READY = "+CPIN: READY";
+static const char *const URC_SOCKET_DATA = "+CIPRXGET: 1";
+static const char *const URC_SOCKET_CLOSED = "CLOSED";
+static const char *const URC_PDP_DEACT = "+PDP: DEACT";
+
 static const char *const HTTPS_PROTO = "https:";
 
 }  // namespace sim800l_data
@@ -3,55 +3,74 @@
 namespace esphome {
 namespace sim800l_data {
 
-void get_response_param_(const std::string &response, const uint8_t p_count, std::string &p1, std::string &p2,
-                         std::string &p3) {
-  // Expample response: +CBC: 1,2,3
-  size_t start = response.find(": ");
-  if (start == std::string::npos) {
-    return;
+ResponseTokenizer::ResponseTokenizer(std::string_view response) {
+  // Example response: +CBC: 1,2,3
+  const size_t start = response.find(": ");
+  this->done_ = start == std::string_view::npos;
+  if (!this->done_) {
+    this->rest_ = response.substr(start + 2);
   }
-  start++;
+}
 
-  for (uint8_t i = 1; i <= p_count; i++) {
-    size_t end = response.find(",", start + 1);
-    if (end == std::string::npos) {
-      end = response.size();
-    }
-    std::string p = response.substr(start + 1, end - start - 1);
-    switch (i) {
-      case 1:
-        p1 = p;
-        break;
-      case 2:
-        p2 = p;
-        break;
-      case 3:
-        p3 = p;
-        return;
-    }
-    if (end >= response.size()) {
-      return;
+bool ResponseTokenizer::next(std::string_view &param) {
+  if (this->done_) {
+    return false;
+  }
+
+  size_t end;
+  if (!this->rest_.empty() && this->rest_.front() == '"') {
+    const size_t quote = this->rest_.find('"', 1);
+    if (quote == std::string_view::npos) {
+      // Unterminated quote, take the rest
+      param = this->rest_.substr(1);
+      this->done_ = true;
+      return true;
     }
-    start = end;
+    param = this->rest_.substr(1, quote - 1);
+    end = this->rest_.find(',', quote + 1);
+  } else {
+    end = this->rest_.find(',');
+    param = this->rest_.substr(0, end);
   }
-}
 
-void get_response_param(const std::string &response, std::string &p1, std::string &p2, std::string &p3) {
-  get_response_param_(response, 3, p1, p2, p3);
+  if (end == std::string_view::npos) {
+    this->done_ = true;
+  } else {
+    this->rest_.remove_prefix(end + 1);
+  }
+  return true;
 }
 
-void get_response_param(const std::string &response, std::string &p1, std::string &p2) {
-  get_response_param_(response, 2, p1, p2, p2);
+bool parse_param(std::string_view param, std::string_view &out) {
+  out = param;
+  return true;
 }
 
-void get_response_param(const std::string &response, std::string &p) { get_response_param_(response, 1, p, p, p); }
+bool parse_param(std::string_view param, std::string &out) {
+  out.assign(param.data(), param.size());
+  return true;
+}
 
-bool is_response_or_urc(const std::string &command, const std::string &response) {
-  size_t length = response.find(":");
-  if (length == std::string::npos) {
+bool parse_http_url(std::string_view url, std::string_view &host, uint16_t &port, std::string_view &path) {
+  // Example: http://example.com:8080/path?query
+  static constexpr std::string_view SCHEME = "http://";
+  if (url.substr(0, SCHEME.size()) != SCHEME) {
     return false;
   }
-  return command.compare(0, length, response, 0, length) == 0;
+  url.remove_prefix(SCHEME.size());
+  const size_t slash = url.find('/');
+  std::string_view authority = url.substr(0, slash);
+  path = slash == std::string_view::npos ? std::string_view("/") : url.substr(slash);
+  port = 80;
+  const size_t colon = authority.find(':');
+  if (colon != std::string_view::npos) {
+    if (!parse_param(authority.substr(colon + 1), port)) {
+      return false;
+    }
+    authority = authority.substr(0, colon);
+  }
+  host = authority;
+  return !host.empty();
 }
 
 int8_t get_rssi_dbm(const uint8_t rssi_param) {
@@ -118,12 +137,55 @@ int8_t get_rssi_dbm(const uint8_t rssi_param) {
   return 0;
 }
 
-const std::string str_concat(const std::string &s1, const std::string &s2, const std::string &s3) {
-  std::string result;
-  result.reserve(s1.size() + s2.size() + s3.size());
-  result.append(s1);
-  result.append(s2);
-  result.append(s3);
+std::string_view url_endpoint(std::string_view url) { return url.substr(0, url.find_first_of("?#")); }
+
+// Returns the query of a URL without ? and fragment.
+static std::string_view url_query(std::string_view url) {
+  const size_t start = url.find('?');
+  if (start == std::string_view::npos) {
+    return {};
+  }
+  url.remove_prefix(start + 1);
+  return url.substr(0, url.find('#'));
+}
+
+// Returns whether the query contains a parameter with the name of param.
+static bool query_has_param(std::string_view query, std::string_view param) {
+  const std::string_view name = param.substr(0, param.find('='));
+  while (!query.empty()) {
+    const size_t end = query.find('&');
+    const std::string_view other = query.substr(0, end);
+    if (other.substr(0, other.find('=')) == name) {
+      return true;
+    }
+    if (end == std::string_view::npos) {
+      break;
+    }
+    query.remove_prefix(end + 1);
+  }
+  return false;
+}
+
+std::string merge_url_query(std::string_view url, std::string_view new_url) {
+  std::string_view new_query = url_query(new_url);
+  std::string result(url_endpoint(new_url));
+  char separator = '?';
+  std::string_view query = url_query(url);
+  while (!query.empty()) {
+    const size_t end = query.find('&');
+    const std::string_view param = query.substr(0, end);
+    if (!param.empty() && !query_has_param(new_query, param)) {
+      result.append(1, separator).append(param);
+      separator = '&';
+    }
+    if (end == std::string_view::npos) {
+      break;
+    }
+    query.remove_prefix(end + 1);
+  }
+  if (!new_query.empty()) {
+    result.append(1, separator).append(new_query);
+  }
   return result;
 }
 
@@ -1,58 +1,69 @@
 #pragma once
 
+#include <charconv>
+#include <string_view>
+
 #include "esphome/core/helpers.h"
 #include "esphome/core/log.h"
 
 namespace esphome {
 namespace sim800l_data {
 
-// Parse up to p_count parameters of the response into p1, p2, p3.
-void get_response_param_(const std::string &response, const uint8_t p_count, std::string &p1, std::string &p2,
-                         std::string &p3);
+// Splits the parameters of a response like +SAPBR: 1,1,"10.0.0.1" without copying.
+// Quoted parameters may contain commas, the quotes are not part of the parameter.
+class ResponseTokenizer {
+ public:
+  explicit ResponseTokenizer(std::string_view response);
+
+  // Get the next parameter. Returns false if there are no more parameters.
+  bool next(std::string_view &param);
 
-void get_response_param(const std::string &response, std::string &p1, std::string &p2, std::string &p3);
+ protected:
+  std::string_view rest_;
+  bool done_;
+};
 
-void get_response_param(const std::string &response, std::string &p1, std::string &p2);
+bool parse_param(std::string_view param, std::string_view &out);
 
-void get_response_param(const std::string &response, std::string &p);
+bool parse_param(std::string_view param, std::string &out);
 
-template<typename T, enable_if_t<(std::is_integral<T>::value && std::is_unsigned<T>::value), int> = 0>
-void get_response_param(const std::string &response, T &p1) {
-  std::string s1;
-  get_response_param_(response, 1, s1, s1, s1);
-  p1 = parse_number<T>(s1).value_or(0);
+template<typename T, enable_if_t<std::is_integral<T>::value, int> = 0>
+bool parse_param(std::string_view param, T &out) {
+  if (!param.empty() && param.front() == '+') {
+    param.remove_prefix(1);
+  }
+  const char *end = param.data() + param.size();
+  const std::from_chars_result result = std::from_chars(param.data(), end, out);
+  return result.ec == std::errc() && result.ptr == end;
 }
 
-template<typename T1, typename T2,
-         enable_if_t<(std::is_integral<T1>::value && std::is_unsigned<T1>::value && std::is_integral<T2>::value &&
-                      std::is_unsigned<T2>::value),
-                     int> = 0>
-void get_response_param(const std::string &response, T1 &p1, T2 &p2) {
-  std::string s1, s2;
-  get_response_param_(response, 2, s1, s2, s2);
-  p1 = parse_number<T1>(s1).value_or(0);
-  p2 = parse_number<T2>(s2).value_or(0);
+template<typename T> bool parse_next_param(ResponseTokenizer &tokenizer, T &out) {
+  std::string_view param;
+  return tokenizer.next(param) && parse_param(param, out);
 }
 
-template<typename T1, typename T2, typename T3,
-         enable_if_t<(std::is_integral<T1>::value && std::is_unsigned<T1>::value && std::is_integral<T2>::value &&
-                      std::is_unsigned<T2>::value && std::is_integral<T3>::value && std::is_unsigned<T3>::value),
-                     int> = 0>
-void get_response_param(const std::string &response, T1 &p1, T2 &p2, T3 &p3) {
-  std::string s1, s2, s3;
-  get_response_param_(response, 3, s1, s2, s3);
-  p1 = parse_number<T1>(s1).value_or(0);
-  p2 = parse_number<T2>(s2).value_or(0);
-  p3 = parse_number<T3>(s3).value_or(0);
+// Parse the parameters of a response into the given outputs, in order.
+// Outputs can be integers (signed or unsigned), std::string or std::string_view.
+// Additional parameters of the response are ignored.
+// Returns false if there are less parameters than outputs or a parameter can't be parsed.
+template<typename... Ts> bool parse_response(std::string_view response, Ts &...out) {
+  ResponseTokenizer tokenizer(response);
+  return (parse_next_param(tokenizer, out) && ...);
 }
 
-// Returns whether the given response is a response or URC for the given command.
-bool is_response_or_urc(const std::string &command, const std::string &response);
+// Split a http:// URL into host, port (default 80) and path (default /) without copying.
+// Returns false for other schemes or an invalid port.
+bool parse_http_url(std::string_view url, std::string_view &host, uint16_t &port, std::string_view &path);
+
+// Returns the URL without query and fragment, which identifies the endpoint.
+std::string_view url_endpoint(std::string_view url);
+
+// Returns new_url with the query parameters of url added that new_url does not set.
+// Example: a?x=1&y=2 merged with a?y=3&z=4 is a?x=1&y=3&z=4
+std::string merge_url_query(std::string_view url, std::string_view new_url);
 
 // Converts the result parameter of +CSQ to a RSSI dBm value.
 int8_t get_rssi_dbm(uint8_t rssi_param);
 
-const std::string str_concat(const std::string &s1, const std::string &s2, const std::string &s3);
-
 }  // namespace sim800l_data
 }  // namespace esphome
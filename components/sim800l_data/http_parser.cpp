@@ -0,0 +1,179 @@
+#include "http_parser.h"
+
+#include <strings.h>
+
+#include "helpers.h"
+
+namespace esphome {
+namespace sim800l_data {
+
+static bool equals_ignore_case(std::string_view a, const char *b) {
+  return a.size() == strlen(b) && strncasecmp(a.data(), b, a.size()) == 0;
+}
+
+static std::string_view trim(std::string_view value) {
+  while (!value.empty() && (value.front() == ' ' || value.front() == '\t')) {
+    value.remove_prefix(1);
+  }
+  while (!value.empty() && (value.back() == ' ' || value.back() == '\t')) {
+    value.remove_suffix(1);
+  }
+  return value;
+}
+
+void HttpResponseParser::reset() {
+  this->stage_ = Stage::STATUS_LINE;
+  this->line_.clear();
+  this->body_.clear();
+  this->status_code_ = 0;
+  this->content_length_ = 0;
+  this->has_content_length_ = false;
+  this->chunked_ = false;
+  this->close_ = false;
+  this->remaining_ = 0;
+  this->until_close_ = false;
+}
+
+size_t HttpResponseParser::feed(const char *data, size_t length) {
+  size_t pos = 0;
+  while (pos < length && this->stage_ != Stage::COMPLETE) {
+    switch (this->stage_) {
+      case Stage::BODY:
+      case Stage::CHUNK_DATA: {
+        size_t count = length - pos;
+        if (!this->until_close_) {
+          count = std::min<size_t>(count, this->remaining_);
+          this->remaining_ -= count;
+        }
+        this->append_body_(data + pos, count);
+        pos += count;
+        if (this->remaining_ == 0 && !this->until_close_) {
+          this->stage_ = this->stage_ == Stage::BODY ? Stage::COMPLETE : Stage::CHUNK_END;
+        }
+      } break;
+
+      default:
+        if (this->read_line_(data, length, pos)) {
+          this->handle_line_();
+          this->line_.clear();
+        }
+        break;
+    }
+  }
+  return pos;
+}
+
+bool HttpResponseParser::finish_on_close() {
+  if (this->stage_ == Stage::BODY && this->until_close_) {
+    this->stage_ = Stage::COMPLETE;
+    return true;
+  }
+  return false;
+}
+
+bool HttpResponseParser::read_line_(const char *data, size_t length, size_t &pos) {
+  while (pos < length) {
+    const char c = data[pos++];
+    if (c == LF) {
+      return true;
+    }
+    // Only the start of long lines is needed
+    if (c != CR && this->line_.size() < RESPONSE_BUFFER_SIZE * 2) {
+      this->line_.push_back(c);
+    }
+  }
+  return false;
+}
+
+void HttpResponseParser::handle_line_() {
+  const std::string_view line = this->line_;
+  switch (this->stage_) {
+    case Stage::STATUS_LINE: {
+      // Example: HTTP/1.1 200 OK
+      const size_t space = line.find(' ');
+      if (space == std::string_view::npos || !parse_param(line.substr(space + 1, 3), this->status_code_)) {
+        this->status_code_ = 0;
+      }
+      // HTTP/1.0 closes the connection unless asked otherwise
+      this->close_ = line.substr(0, 8) == "HTTP/1.0";
+      this->stage_ = Stage::HEADERS;
+    } break;
+
+    case Stage::HEADERS: {
+      if (line.empty()) {
+        this->headers_done_();
+        break;
+      }
+      const size_t colon = line.find(':');
+      if (colon != std::string_view::npos) {
+        this->handle_header_(trim(line.substr(0, colon)), trim(line.substr(colon + 1)));
+      }
+    } break;
+
+    case Stage::CHUNK_SIZE: {
+      // Example: 1a3;extension
+      const std::string_view size = line.substr(0, line.find(';'));
+      uint32_t chunk_size = 0;
+      const std::from_chars_result result =
+          std::from_chars(size.data(), size.data() + size.size(), chunk_size, 16);
+      if (result.ec != std::errc()) {
+        chunk_size = 0;
+      }
+      this->remaining_ = chunk_size;
+      this->stage_ = chunk_size > 0 ? Stage::CHUNK_DATA : Stage::TRAILERS;
+    } break;
+
+    case Stage::CHUNK_END:
+      this->stage_ = Stage::CHUNK_SIZE;
+      break;
+
+    case Stage::TRAILERS:
+      if (line.empty()) {
+        this->stage_ = Stage::COMPLETE;
+      }
+      break;
+
+    default:
+      break;
+  }
+}
+
+void HttpResponseParser::handle_header_(std::string_view name, std::string_view value) {
+  if (equals_ignore_case(name, "Content-Length")) {
+    this->has_content_length_ = parse_param(value, this->content_length_);
+  } else if (equals_ignore_case(name, "Transfer-Encoding")) {
+    this->chunked_ = value.size() >= 7 && equals_ignore_case(value.substr(value.size() - 7), "chunked");
+  } else if (equals_ignore_case(name, "Connection")) {
+    if (equals_ignore_case(value, "close")) {
+      this->close_ = true;
+    } else if (equals_ignore_case(value, "keep-alive")) {
+      this->close_ = false;
+    }
+  }
+}
+
+void HttpResponseParser::headers_done_() {
+  // 1xx, 204 and 304 responses never have a body
+  if ((this->status_code_ >= 100 && this->status_code_ < 200) || this->status_code_ == 204 ||
+      this->status_code_ == 304) {
+    this->stage_ = Stage::COMPLETE;
+  } else if (this->chunked_) {
+    this->stage_ = Stage::CHUNK_SIZE;
+  } else if (this->has_content_length_) {
+    this->remaining_ = this->content_length_;
+    this->stage_ = this->remaining_ > 0 ? Stage::BODY : Stage::COMPLETE;
+  } else {
+    // Without framing the body ends with the connection
+    this->until_close_ = true;
+    this->close_ = true;
+    this->stage_ = Stage::BODY;
+  }
+}
+
+void HttpResponseParser::append_body_(const char *data, size_t length) {
+  const size_t room = MAX_HTTP_RESPONSE_SIZE > this->body_.size() ? MAX_HTTP_RESPONSE_SIZE - this->body_.size() : 0;
+  this->body_.append(data, std::min(length, room));
+}
+
+}  // namespace sim800l_data
+}  // namespace esphome
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#include "esphome/core/helpers.h"
+
+#include "constants.h"
+
+namespace esphome {
+namespace sim800l_data {
+
+// Incremental parser for HTTP/1.1 responses received over a socket.
+// Data can be fed in blocks of any size; the body is framed by Content-Length
+// or chunked transfer encoding, or lasts until the connection is closed.
+// Bodies longer than MAX_HTTP_RESPONSE_SIZE are truncated.
+class HttpResponseParser {
+ public:
+  // Prepare for the next response. The body keeps its capacity.
+  void reset();
+
+  // Parse up to length bytes. Stops after a complete response, so the rest of
+  // the data belongs to the next one. Returns the number of bytes consumed.
+  size_t feed(const char *data, size_t length);
+
+  // Complete a response whose body lasts until the connection is closed.
+  // Returns true if a response was completed.
+  bool finish_on_close();
+
+  bool complete() const { return this->stage_ == Stage::COMPLETE; }
+  // Whether any byte of the current response has been received.
+  bool started() const { return this->stage_ != Stage::STATUS_LINE || !this->line_.empty(); }
+  uint16_t status_code() const { return this->status_code_; }
+  // Whether the server keeps the connection open after this response.
+  bool keep_alive() const { return !this->close_; }
+  std::string &body() { return this->body_; }
+
+ protected:
+  enum class Stage : uint8_t {
+    STATUS_LINE,
+    HEADERS,
+    BODY,        // Content-Length or until close
+    CHUNK_SIZE,
+    CHUNK_DATA,
+    CHUNK_END,   // CRLF after chunk data
+    TRAILERS,
+    COMPLETE,
+  };
+
+  // Collect a line into line_. Returns true when the line is complete.
+  bool read_line_(const char *data, size_t length, size_t &pos);
+  void handle_line_();
+  void handle_header_(std::string_view name, std::string_view value);
+  void headers_done_();
+  void append_body_(const char *data, size_t length);
+
+  Stage stage_{Stage::STATUS_LINE};
+  std::string line_;
+  std::string body_;
+  uint16_t status_code_{0};
+  uint32_t content_length_{0};
+  bool has_content_length_{false};
+  bool chunked_{false};
+  bool close_{false};
+  // Bytes left of the body (Content-Length) or of the current chunk.
+  uint32_t remaining_{0};
+  bool until_close_{false};
+};
+
+}  // namespace sim800l_data
+}  // namespace esphome
@@ -0,0 +1,115 @@
+#include "outbox.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace esphome {
+namespace sim800l_data {
+
+void Outbox::setup(size_t capacity) {
+  // Include the capacity and entry size, so a ring with a different layout is not loaded
+  const uint32_t hash = fnv1_hash("sim800l_data_outbox") + capacity * OUTBOX_ENTRY_SIZE;
+  this->slots_.resize(capacity);
+  this->head_ = 0;
+  this->size_ = 0;
+
+  // Entries are written in order and removed from the front, so the used slots are
+  // contiguous and the one with the lowest sequence number is the oldest.
+  uint32_t oldest = 0;
+  OutboxEntry entry;
+  for (size_t i = 0; i < capacity; i++) {
+    Slot &slot = this->slots_[i];
+    slot.pref = global_preferences->make_preference<OutboxEntry>(hash + i, true);
+    slot.sequence = slot.pref.load(&entry) ? entry.sequence : 0;
+    if (slot.sequence == 0) {
+      continue;
+    }
+    this->size_++;
+    if (oldest == 0 || slot.sequence < oldest) {
+      oldest = slot.sequence;
+      this->head_ = i;
+    }
+    if (slot.sequence >= this->next_sequence_) {
+      this->next_sequence_ = slot.sequence + 1;
+    }
+  }
+}
+
+bool Outbox::push(const std::string &payload) {
+  if (payload.size() > OUTBOX_ENTRY_SIZE || this->slots_.empty()) {
+    return false;
+  }
+  OutboxEntry entry{};
+  entry.sequence = this->next_sequence_;
+  entry.length = payload.size();
+  memcpy(entry.data, payload.data(), payload.size());
+  // When full, this is the slot of the oldest entry
+  Slot &slot = this->at(this->size_);
+  if (!slot.pref.save(&entry)) {
+    return false;
+  }
+  if (this->size_ == this->slots_.size()) {
+    // Full, the oldest entry was overwritten
+    this->head_ = (this->head_ + 1) % this->slots_.size();
+    this->size_--;
+    this->dropped_++;
+  }
+  slot.sequence = entry.sequence;
+  this->next_sequence_++;
+  this->size_++;
+  return true;
+}
+
+bool Outbox::load(size_t index, OutboxEntry &entry) {
+  Slot &slot = this->at(index);
+  return slot.pref.load(&entry) && entry.sequence == slot.sequence && entry.length <= OUTBOX_ENTRY_SIZE;
+}
+
+size_t Outbox::read_body(const std::vector<OutboxPart> &parts, uint32_t offset, uint8_t *buffer, size_t length) {
+  OutboxEntry entry;
+  size_t written = 0;
+  uint32_t start = 0;
+  for (size_t i = 0; i < parts.size() && written < length; i++) {
+    const OutboxPart &part = parts[i];
+    // The part and the newline after it, except after the last one
+    const uint32_t end = start + part.length + (i + 1 < parts.size() ? 1 : 0);
+    const uint32_t pos = offset + written;
+    if (pos < end) {
+      const uint32_t part_offset = pos - start;
+      if (part_offset < part.length) {
+        const size_t count = std::min<size_t>(part.length - part_offset, length - written);
+        // The entry is found by its sequence number, entries added since the flush started moved the indices
+        size_t index = 0;
+        while (index < this->size_ && this->at(index).sequence != part.sequence) {
+          index++;
+        }
+        if (index < this->size_ && this->load(index, entry) && entry.length == part.length) {
+          memcpy(buffer + written, entry.data + part_offset, count);
+        } else {
+          memset(buffer + written, ' ', count);
+        }
+        written += count;
+      }
+      if (written < length && offset + written < end) {
+        buffer[written++] = '\n';
+      }
+    }
+    start = end;
+  }
+  return written;
+}
+
+void Outbox::remove_through(uint32_t sequence) {
+  // If clearing a slot fails, its entry is loaded and sent again after a reboot
+  OutboxEntry entry{};
+  while (this->size_ > 0 && this->at(0).sequence <= sequence) {
+    Slot &slot = this->at(0);
+    slot.sequence = 0;
+    slot.pref.save(&entry);
+    this->head_ = (this->head_ + 1) % this->slots_.size();
+    this->size_--;
+  }
+}
+
+}  // namespace sim800l_data
+}  // namespace esphome
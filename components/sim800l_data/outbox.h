@@ -0,0 +1,76 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "esphome/core/helpers.h"
+#include "esphome/core/preferences.h"
+
+#include "constants.h"
+
+namespace esphome {
+namespace sim800l_data {
+
+// One payload as stored in flash. Slots with sequence 0 are empty.
+struct OutboxEntry {
+  uint32_t sequence;
+  uint16_t length;
+  char data[OUTBOX_ENTRY_SIZE];
+};
+
+// An entry included in an outbox flush and its length in the body.
+struct OutboxPart {
+  uint32_t sequence;
+  uint16_t length;
+};
+
+// Fixed-size ring of payloads in flash, one preference per slot, so entries survive reboots.
+// Only the sequence numbers are kept in RAM, the payloads are read from flash when they are sent.
+class Outbox {
+ public:
+  // Create the preferences of capacity slots and find the stored entries.
+  void setup(size_t capacity);
+
+  size_t capacity() const { return this->slots_.size(); }
+  size_t size() const { return this->size_; }
+  bool empty() const { return this->size_ == 0; }
+
+  // Number of entries that were overwritten because the outbox was full.
+  uint32_t get_dropped() const { return this->dropped_; }
+
+  // Store payload after the newest entry, overwriting the oldest one if full.
+  // Returns false if it is longer than OUTBOX_ENTRY_SIZE or could not be saved; the outbox is unchanged then.
+  bool push(const std::string &payload);
+
+  // Load the entry at index, counted from the oldest. Returns false if it could not be read.
+  bool load(size_t index, OutboxEntry &entry);
+
+  // Write up to length bytes at offset of the body made of parts, separated by newlines, into buffer.
+  // The entries are read from flash as needed. An entry that was overwritten in the meantime reads as spaces,
+  // so the body keeps its size. Returns the number of bytes written.
+  size_t read_body(const std::vector<OutboxPart> &parts, uint32_t offset, uint8_t *buffer, size_t length);
+
+  // Sequence number of the entry at index, counted from the oldest.
+  uint32_t sequence(size_t index) { return this->at(index).sequence; }
+
+  // Remove all entries up to and including the one with this sequence number.
+  // Entries added in the meantime are kept, and overwritten ones are not counted twice.
+  void remove_through(uint32_t sequence);
+
+ protected:
+  struct Slot {
+    ESPPreferenceObject pref;
+    uint32_t sequence;
+  };
+
+  Slot &at(size_t index) { return this->slots_[(this->head_ + index) % this->slots_.size()]; }
+
+  std::vector<Slot> slots_;
+  size_t head_{0};
+  size_t size_{0};
+  uint32_t next_sequence_{1};
+  uint32_t dropped_{0};
+};
+
+}  // namespace sim800l_data
+}  // namespace esphome
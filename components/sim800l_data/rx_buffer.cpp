@@ -0,0 +1,44 @@
+#include "rx_buffer.h"
+
+namespace esphome {
+namespace sim800l_data {
+
+size_t RxBuffer::write_length() const {
+  const size_t tail = (this->head_ + this->size_) % RX_BUFFER_SIZE;
+  if (tail >= this->head_ && this->size_ < RX_BUFFER_SIZE) {
+    return RX_BUFFER_SIZE - tail;
+  }
+  return this->head_ - tail;
+}
+
+int RxBuffer::find(uint8_t c) const {
+  // Search the two contiguous parts of the ring separately
+  const size_t first = std::min<size_t>(this->size_, RX_BUFFER_SIZE - this->head_);
+  const void *found = memchr(&this->data_[this->head_], c, first);
+  if (found != nullptr) {
+    return static_cast<const uint8_t *>(found) - &this->data_[this->head_];
+  }
+  found = memchr(&this->data_[0], c, this->size_ - first);
+  if (found != nullptr) {
+    return first + (static_cast<const uint8_t *>(found) - &this->data_[0]);
+  }
+  return -1;
+}
+
+void RxBuffer::pop(std::string &out, size_t length) {
+  const size_t first = std::min<size_t>(length, RX_BUFFER_SIZE - this->head_);
+  out.append(reinterpret_cast<const char *>(&this->data_[this->head_]), first);
+  out.append(reinterpret_cast<const char *>(&this->data_[0]), length - first);
+  this->drop(length);
+}
+
+void RxBuffer::drop(size_t length) {
+  this->head_ = (this->head_ + length) % RX_BUFFER_SIZE;
+  this->size_ -= length;
+  if (this->size_ == 0) {
+    this->head_ = 0;
+  }
+}
+
+}  // namespace sim800l_data
+}  // namespace esphome
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <algorithm>
+
+#include "esphome/core/helpers.h"
+
+#include "constants.h"
+
+namespace esphome {
+namespace sim800l_data {
+
+// Fixed-capacity ring buffer for bytes received from the module.
+// Data is appended in blocks from the UART and removed line by line or in chunks,
+// so the RX path does not allocate.
+class RxBuffer {
+ public:
+  size_t size() const { return this->size_; }
+
+  bool empty() const { return this->size_ == 0; }
+
+  size_t free() const { return RX_BUFFER_SIZE - this->size_; }
+
+  // Contiguous free space at the end of the buffer. Call commit() after writing to it.
+  uint8_t *write_ptr() { return &this->data_[(this->head_ + this->size_) % RX_BUFFER_SIZE]; }
+
+  // Length of the contiguous free space returned by write_ptr().
+  size_t write_length() const;
+
+  // Mark length bytes at write_ptr() as written.
+  void commit(size_t length) { this->size_ += length; }
+
+  // Returns the byte at index, counted from the front.
+  uint8_t at(size_t index) const { return this->data_[(this->head_ + index) % RX_BUFFER_SIZE]; }
+
+  // Returns the index of the first occurrence of c, or -1 if not found.
+  int find(uint8_t c) const;
+
+  // Remove length bytes from the front and append them to out.
+  void pop(std::string &out, size_t length);
+
+  // Remove length bytes from the front.
+  void drop(size_t length);
+
+  void clear() {
+    this->head_ = 0;
+    this->size_ = 0;
+  }
+
+ protected:
+  uint8_t data_[RX_BUFFER_SIZE];
+  uint16_t head_{0};
+  uint16_t size_{0};
+};
+
+}  // namespace sim800l_data
+}  // namespace esphome
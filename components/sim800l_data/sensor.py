@@ -10,9 +10,12 @@ from esphome.const import (
     DEVICE_CLASS_SIGNAL_STRENGTH,
     DEVICE_CLASS_VOLTAGE,
     ENTITY_CATEGORY_DIAGNOSTIC,
+    ICON_TIMER,
     STATE_CLASS_MEASUREMENT,
+    STATE_CLASS_TOTAL_INCREASING,
     UNIT_DECIBEL_MILLIWATT,
     UNIT_PERCENT,
+    UNIT_SECOND,
     UNIT_VOLT,
 )
 
@@ -20,6 +23,27 @@ from . import Sim800LDataComponent
 
 DEPENDENCIES = ["sim800l_data"]
 
+CONF_COMMAND_ERRORS = "command_errors"
+CONF_COMMAND_TIMEOUTS = "command_timeouts"
+CONF_BEARER_OPEN_TIME = "bearer_open_time"
+CONF_HTTP_ACTION_TIME = "http_action_time"
+CONF_HTTP_READ_TIME = "http_read_time"
+CONF_RX_OVERRUNS = "rx_overruns"
+CONF_RX_PURGES = "rx_purges"
+
+_COUNTER_SCHEMA = sensor.sensor_schema(
+    accuracy_decimals=0,
+    state_class=STATE_CLASS_TOTAL_INCREASING,
+    entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+)
+
+_TIME_SCHEMA = sensor.sensor_schema(
+    unit_of_measurement=UNIT_SECOND,
+    icon=ICON_TIMER,
+    accuracy_decimals=1,
+    state_class=STATE_CLASS_TOTAL_INCREASING,
+    entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
+)
 
 CONFIG_SCHEMA = {
     cv.GenerateID(): cv.use_id(Sim800LDataComponent),
@@ -43,6 +67,13 @@ CONFIG_SCHEMA = {
         state_class=STATE_CLASS_MEASUREMENT,
         entity_category=ENTITY_CATEGORY_DIAGNOSTIC,
     ),
+    cv.Optional(CONF_COMMAND_ERRORS): _COUNTER_SCHEMA,
+    cv.Optional(CONF_COMMAND_TIMEOUTS): _COUNTER_SCHEMA,
+    cv.Optional(CONF_RX_OVERRUNS): _COUNTER_SCHEMA,
+    cv.Optional(CONF_RX_PURGES): _COUNTER_SCHEMA,
+    cv.Optional(CONF_BEARER_OPEN_TIME): _TIME_SCHEMA,
+    cv.Optional(CONF_HTTP_ACTION_TIME): _TIME_SCHEMA,
+    cv.Optional(CONF_HTTP_READ_TIME): _TIME_SCHEMA,
 }
 
 
@@ -53,6 +84,13 @@ async def to_code(config):
         CONF_SIGNAL_STRENGTH,
         CONF_BATTERY_LEVEL,
         CONF_BATTERY_VOLTAGE,
+        CONF_COMMAND_ERRORS,
+        CONF_COMMAND_TIMEOUTS,
+        CONF_RX_OVERRUNS,
+        CONF_RX_PURGES,
+        CONF_BEARER_OPEN_TIME,
+        CONF_HTTP_ACTION_TIME,
+        CONF_HTTP_READ_TIME,
     ]:
         if key not in config:
             continue
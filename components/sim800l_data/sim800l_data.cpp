@@ -4,9 +4,56 @@ namespace esphome {
 namespace sim800l_data {
 
 void Sim800LDataComponent::setup() {
-  // wait for SIM module to start before initialization starts
+  // Initialization starts right away: INIT repeats a short AT until the module has started
+  // and detected the baud rate, or it reports RDY. The waits for the SIM and the network
+  // end as soon as their URCs are received.
   this->state_ = State::INIT;
-  this->wait_.start(SETUP_WAIT);
+  this->read_buffer_.reserve(MAX_READ_BUFFER_SIZE);
+  // Checks without their own interval run every update_interval. Registration changes
+  // are reported by +CREG URCs, so it is only polled if an interval is configured.
+  if (this->battery_check_interval_ == 0) {
+    this->battery_check_interval_ = this->get_update_interval();
+  }
+  if (this->signal_check_interval_ == 0) {
+    this->signal_check_interval_ = this->get_update_interval();
+  }
+  this->command_state_.reserve();
+  if (this->dtr_pin_ != nullptr) {
+    // Keep the module awake until idle sleep starts
+    this->dtr_pin_->setup();
+    this->dtr_pin_->digital_write(false);
+  }
+  this->initial_baud_rate_ = this->parent_->get_baud_rate();
+  this->setup_flow_control_();
+  if (this->adaptive_timeouts_ && this->persist_timeouts_) {
+    // Include the number of commands, so estimates of a different command table are not loaded
+    const uint32_t hash = fnv1_hash("sim800l_data_timeouts") + ADAPTIVE_COMMAND_COUNT;
+    this->timeout_pref_ = global_preferences->make_preference<TimeoutEstimates>(hash, true);
+    if (this->timeout_pref_.load(&this->timeout_estimates_)) {
+      ESP_LOGD(TAG, "Loaded latency estimates of adaptive timeouts");
+    }
+  }
+  if (this->http_queue_.capacity() == 0) {
+    this->http_queue_.set_capacity(DEFAULT_HTTP_QUEUE_SIZE);
+  }
+  if (this->outbox_size_ > 0) {
+    this->outbox_.setup(this->outbox_size_);
+    if (!this->outbox_.empty()) {
+      ESP_LOGI(TAG, "Outbox has %u stored entries", (unsigned) this->outbox_.size());
+    }
+  }
+
+  this->subscribe_urc(URC_REGISTRATION, [this](const std::string &line) { this->on_registration_urc_(line); });
+  this->subscribe_urc(URC_BEARER_DEACT, [this](const std::string &line) { this->on_bearer_deact_urc_(line); });
+  this->subscribe_urc(URC_READY, [this](const std::string &line) { this->on_ready_urc_(line); });
+  this->subscribe_urc(URC_SOCKET_DATA, [this](const std::string &line) { this->socket_rx_pending_ = true; });
+  this->subscribe_urc(URC_SOCKET_CLOSED, [this](const std::string &line) { this->on_socket_lost_urc_(line); });
+  this->subscribe_urc(URC_PDP_DEACT, [this](const std::string &line) { this->on_socket_lost_urc_(line); });
+  this->subscribe_urc(URC_UNDER_VOLTAGE, [](const std::string &line) { ESP_LOGW(TAG, "%s", line.c_str()); });
+  this->subscribe_urc(URC_OVER_VOLTAGE, [](const std::string &line) { ESP_LOGW(TAG, "%s", line.c_str()); });
+  this->subscribe_urc(URC_PIN_READY, [this](const std::string &line) { this->on_sim_ready_urc_(line); });
+  this->subscribe_urc(URC_CALL_READY, [this](const std::string &line) { this->on_sim_ready_urc_(line); });
+  this->subscribe_urc(URC_SMS_READY, [this](const std::string &line) { this->on_sim_ready_urc_(line); });
 }
 
 void Sim800LDataComponent::dump_config() {
@@ -16,29 +63,153 @@ void Sim800LDataComponent::dump_config() {
   ESP_LOGCONFIG(TAG, "  APN User: %s", this->apn_user_.c_str());
   ESP_LOGCONFIG(TAG, "  APN Password: %s", this->apn_password_.c_str());
   ESP_LOGCONFIG(TAG, "  Idle Sleep: %s", YESNO(this->idle_sleep_));
+  LOG_PIN("  DTR Pin: ", this->dtr_pin_);
+  if (this->target_baud_rate_ > 0) {
+    ESP_LOGCONFIG(TAG, "  Target Baud Rate: %u%s", this->target_baud_rate_,
+                  this->baud_rate_failed_ ? " (failed)" : "");
+  }
+  ESP_LOGCONFIG(TAG, "  Battery Check Interval: %u ms", this->battery_check_interval_);
+  if (this->registration_check_interval_ > 0) {
+    ESP_LOGCONFIG(TAG, "  Registration Check Interval: %u ms", this->registration_check_interval_);
+  } else {
+    ESP_LOGCONFIG(TAG, "  Registration Check Interval: URC only");
+  }
+  ESP_LOGCONFIG(TAG, "  Signal Check Interval: %u ms", this->signal_check_interval_);
+  ESP_LOGCONFIG(TAG, "  HTTP Queue Size: %u", (unsigned) this->http_queue_.capacity());
+  ESP_LOGCONFIG(TAG, "  Keep Bearer Open: %u ms", this->keep_bearer_open_);
+  if (this->outbox_.capacity() > 0) {
+    ESP_LOGCONFIG(TAG, "  Outbox: %s, %u/%u entries", this->outbox_url_.c_str(), (unsigned) this->outbox_.size(),
+                  (unsigned) this->outbox_.capacity());
+  }
+  if (this->flow_control_enabled_()) {
+    ESP_LOGCONFIG(TAG, "  Flow Control: RTS GPIO%d, CTS GPIO%d", this->rts_pin_, this->cts_pin_);
+  }
+  ESP_LOGCONFIG(TAG, "  RX Overruns: %u", this->rx_overruns_);
+  ESP_LOGCONFIG(TAG, "  RX Purges: %u", this->rx_purges_);
+  ESP_LOGCONFIG(TAG, "  Command Buffer Allocations: %u", this->command_allocations_);
+  ESP_LOGCONFIG(TAG, "  Adaptive Timeouts: %s", YESNO(this->adaptive_timeouts_));
+  if (this->adaptive_timeouts_) {
+    ESP_LOGCONFIG(TAG, "  Persist Timeouts: %s", YESNO(this->persist_timeouts_));
+  }
+  ESP_LOGCONFIG(TAG, "  HTTP Stats: %s", YESNO(this->http_stats_));
+  ESP_LOGCONFIG(TAG, "  Stream Response: %s", YESNO(this->stream_response_));
+  if (this->stream_response_) {
+    ESP_LOGCONFIG(TAG, "  Response Chunk Size: %d", this->response_chunk_size_);
+  }
 #ifdef USE_SENSOR
   LOG_SENSOR("  ", "Signal Strength", this->signal_strength_sensor_);
   LOG_SENSOR("  ", "Battery Level", this->battery_level_sensor_);
   LOG_SENSOR("  ", "Battery Voltage", this->battery_voltage_sensor_);
+  LOG_SENSOR("  ", "Command Errors", this->command_errors_sensor_);
+  LOG_SENSOR("  ", "Command Timeouts", this->command_timeouts_sensor_);
+  LOG_SENSOR("  ", "RX Overruns", this->rx_overruns_sensor_);
+  LOG_SENSOR("  ", "RX Purges", this->rx_purges_sensor_);
+  LOG_SENSOR("  ", "Bearer Open Time", this->bearer_open_time_sensor_);
+  LOG_SENSOR("  ", "HTTP Action Time", this->http_action_time_sensor_);
+  LOG_SENSOR("  ", "HTTP Read Time", this->http_read_time_sensor_);
 #endif
+  this->dump_stats_();
 }
 
-void Sim800LDataComponent::update() {
-  // do nothing if we are waiting, or a command is pending
-  if (this->wait_.is_waiting() || this->command_state_.is_pending) {
-    return;
+void Sim800LDataComponent::dump_stats_() {
+  char histogram[96];
+  bool header = false;
+  for (size_t i = 0; i < static_cast<size_t>(CommandId::COUNT); i++) {
+    const CommandStats &stats = this->command_stats_[i];
+    if (stats.latency.count == 0) {
+      continue;
+    }
+    if (!header) {
+      ESP_LOGCONFIG(TAG, "  Command Stats (ok/error/timeout, total/max ms, histogram):");
+      header = true;
+    }
+    stats.latency.format(histogram, sizeof(histogram));
+    ESP_LOGCONFIG(TAG, "    AT%s: %u/%u/%u, %u/%u ms, %s", COMMANDS[i].text, stats.successes, stats.errors,
+                  stats.timeouts, stats.latency.total, stats.latency.max, histogram);
+  }
+  header = false;
+  for (size_t i = 0; i < static_cast<size_t>(CommandId::COUNT); i++) {
+    const LatencyEstimate *estimate = this->timeout_estimates_.find(static_cast<CommandId>(i));
+    if (!this->adaptive_timeouts_ || estimate == nullptr || estimate->samples < ADAPTIVE_TIMEOUT_MIN_SAMPLES) {
+      continue;
+    }
+    if (!header) {
+      ESP_LOGCONFIG(TAG, "  Adaptive Timeouts (mean/deviation/timeout ms):");
+      header = true;
+    }
+    ESP_LOGCONFIG(TAG, "    AT%s: %u/%u/%u ms", COMMANDS[i].text, estimate->mean, estimate->deviation,
+                  estimate->timeout(COMMANDS[i].max_runtime()));
   }
+  header = false;
+  for (size_t i = 0; i < STATE_COUNT; i++) {
+    const LatencyHistogram &latency = this->state_latency_[i];
+    if (latency.count == 0) {
+      continue;
+    }
+    if (!header) {
+      ESP_LOGCONFIG(TAG, "  State Stats (count, total/max ms, histogram):");
+      header = true;
+    }
+    latency.format(histogram, sizeof(histogram));
+    ESP_LOGCONFIG(TAG, "    %s: %u, %u/%u ms, %s", state_to_string(static_cast<State>(i)), latency.count,
+                  latency.total, latency.max, histogram);
+  }
+}
 
-  // if we are idle, restart all checks
-  if (this->state_ == State::IDLE) {
-    this->state_ = State::INIT;
+void Sim800LDataComponent::update() {
+  // The full initialization only runs once, or after an error. After that, battery,
+  // registration and signal quality are checked from IDLE, each on its own interval.
+  // Here only the latency estimates are saved and the diagnostic counters are published.
+  const uint32_t now = millis();
+  if (this->persist_timeouts_ && this->timeout_estimates_changed_ &&
+      (!this->timeout_estimates_saved_ || now - this->last_timeout_save_ >= TIMEOUT_SAVE_INTERVAL)) {
+    if (this->timeout_pref_.save(&this->timeout_estimates_)) {
+      this->timeout_estimates_changed_ = false;
+      this->timeout_estimates_saved_ = true;
+      this->last_timeout_save_ = now;
+    } else {
+      ESP_LOGW(TAG, "Latency estimates could not be saved");
+    }
   }
+#ifdef USE_SENSOR
+  uint32_t errors = 0;
+  uint32_t timeouts = 0;
+  for (const auto &stats : this->command_stats_) {
+    errors += stats.errors;
+    timeouts += stats.timeouts;
+  }
+  if (this->command_errors_sensor_ != nullptr) {
+    this->command_errors_sensor_->publish_state(errors);
+  }
+  if (this->command_timeouts_sensor_ != nullptr) {
+    this->command_timeouts_sensor_->publish_state(timeouts);
+  }
+  if (this->rx_overruns_sensor_ != nullptr) {
+    this->rx_overruns_sensor_->publish_state(this->rx_overruns_);
+  }
+  if (this->rx_purges_sensor_ != nullptr) {
+    this->rx_purges_sensor_->publish_state(this->rx_purges_);
+  }
+  if (this->bearer_open_time_sensor_ != nullptr) {
+    this->bearer_open_time_sensor_->publish_state(this->command_time_(CommandId::BEARER_OPEN) / 1000.0f);
+  }
+  if (this->http_action_time_sensor_ != nullptr) {
+    this->http_action_time_sensor_->publish_state(this->command_time_(CommandId::HTTP_ACTION) / 1000.0f);
+  }
+  if (this->http_read_time_sensor_ != nullptr) {
+    this->http_read_time_sensor_->publish_state(
+        (this->command_time_(CommandId::HTTP_READ) + this->command_time_(CommandId::HTTP_READ_RANGE)) / 1000.0f);
+  }
+#endif
 }
 
 void Sim800LDataComponent::loop() {
   // Handle incoming messages. Returns true if no command execution
   // is pending and no new data is received.
-  if (!this->handle_response_()) {
+  const uint32_t rx_start = micros();
+  const bool ready = this->handle_response_();
+  this->rx_time_us_ += micros() - rx_start;
+  if (!ready) {
     return;
   }
 
@@ -47,60 +218,152 @@ void Sim800LDataComponent::loop() {
     return;
   }
 
+  if (this->state_ != this->last_state_) {
+    const uint32_t now = millis();
+    ESP_LOGV(TAG, "State %s -> %s", state_to_string(this->last_state_), state_to_string(this->state_));
+    const uint32_t duration = now - this->state_entered_at_;
+    this->state_time_[static_cast<size_t>(this->last_state_)] += duration;
+    this->state_latency_[static_cast<size_t>(this->last_state_)].add(duration);
+    this->state_entered_at_ = now;
+    this->last_state_ = this->state_;
+    this->state_transitions_++;
+  }
+
   // Send command. While command execution is pending, we will not reach this
   // point again; only after a command succeeded or failed.
   switch (this->state_) {
     case State::INIT:
-    INIT:
-      this->await_ok_("", State::DISABLE_ECHO);
+      // Cold path: runs once, and again after errors.
+      this->initialized_ = false;
+      if (idle_sleep_active_ && this->dtr_pin_ != nullptr) {
+        // Wake with DTR first, the module can't answer while DTR is high
+        goto WAKE;
+      }
+      // If the module does not answer, it may be using the other baud rate: it restarted and
+      // autobauds at the initial rate, or the ESP restarted and the module kept the target rate.
+      this->await_(CommandId::AT_SYNC, State::DISABLE_ECHO,
+                   this->target_baud_rate_ > 0 ? State::SYNC_BAUD_RATE : State::INIT);
       if (idle_sleep_active_) {
         this->wait_.start(AT_SLEEP_WAIT);
       }
       break;
 
-    case State::DISABLE_ECHO: {
+    case State::WAKE:
+    WAKE:
+      if (this->dtr_pin_ != nullptr) {
+        // The module wakes while DTR is low, no commands are needed
+        this->dtr_pin_->digital_write(false);
+        this->idle_sleep_active_ = false;
+        this->state_ = this->initialized_ ? State::IDLE : State::INIT;
+        this->wait_.start(DTR_WAKE_WAIT);
+        break;
+      }
+      // Wake the module from sleep. The first AT may be lost, so ignore failure.
+      this->await_(CommandId::AT, State::DISABLE_SLEEP, State::DISABLE_SLEEP);
+      this->wait_.start(AT_SLEEP_WAIT);
+      break;
+
+    case State::DISABLE_ECHO:
+      this->await_(CommandId::DISABLE_ECHO, State::SET_BAUD_RATE);
+      break;
+
+    case State::SYNC_BAUD_RATE: {
+      // Only probe the other rate with AT. AT+IPR is sent after the module answered.
+      const uint32_t baud_rate = this->parent_->get_baud_rate() == this->target_baud_rate_ ? this->initial_baud_rate_
+                                                                                          : this->target_baud_rate_;
+      ESP_LOGD(TAG, "No response at %u baud, trying %u baud", this->parent_->get_baud_rate(), baud_rate);
+      this->set_uart_baud_rate_(baud_rate);
+      this->state_ = State::INIT;
+      this->wait_.start(BAUD_RATE_SWITCH_WAIT);
+    } break;
+
+    case State::SET_BAUD_RATE:
+      if (this->target_baud_rate_ > 0 && !this->baud_rate_failed_ &&
+          this->parent_->get_baud_rate() != this->target_baud_rate_) {
+        // The module answers OK at the old rate, then switches
+        char argument[12];
+        snprintf(argument, sizeof(argument), "%u", this->target_baud_rate_);
+        this->await_(CommandId::SET_BAUD_RATE, State::SWITCH_BAUD_RATE, State::BAUD_RATE_FAILED, argument);
+        break;
+      }
+      this->state_ = State::ENABLE_FLOW_CONTROL;
+      goto ENABLE_FLOW_CONTROL;
+
+    case State::SWITCH_BAUD_RATE:
+      ESP_LOGI(TAG, "Switching to %u baud", this->target_baud_rate_);
+      this->set_uart_baud_rate_(this->target_baud_rate_);
+      this->state_ = State::CHECK_BAUD_RATE;
+      this->wait_.start(BAUD_RATE_SWITCH_WAIT);
+      break;
+
+    case State::CHECK_BAUD_RATE:
+      this->await_(CommandId::AT, State::ENABLE_FLOW_CONTROL, State::BAUD_RATE_FAILED);
+      break;
+
+    case State::BAUD_RATE_FAILED:
+      // Keep the initial rate until the next boot. If the module already switched, it
+      // only autobauds at the initial rate again after it has been power cycled.
+      ESP_LOGE(TAG, "Could not switch to %u baud, staying at %u baud", this->target_baud_rate_,
+               this->initial_baud_rate_);
+      this->baud_rate_failed_ = true;
+      this->set_uart_baud_rate_(this->initial_baud_rate_);
+      this->state_ = State::INIT;
+      this->wait_.start(FUTILE_WAIT);
+      break;
+
+    case State::ENABLE_FLOW_CONTROL:
+    ENABLE_FLOW_CONTROL: {
+      // Let the module stop sending with RTS while the ESP RX FIFO is full, and vice versa with CTS
       const State next_state = idle_sleep_active_ ? State::DISABLE_SLEEP : State::CHECK_BATTERY;
-      this->await_ok_("E0", next_state);
+      if (this->flow_control_enabled_()) {
+        this->await_(CommandId::ENABLE_FLOW_CONTROL, next_state);
+        break;
+      }
+      this->state_ = next_state;
     } break;
 
     case State::DISABLE_SLEEP:
-      this->await_ok_("+CSCLK=0", State::CHECK_BATTERY);
+      this->await_(CommandId::DISABLE_SLEEP, this->initialized_ ? State::IDLE : State::CHECK_BATTERY);
       idle_sleep_active_ = false;
       break;
 
     case State::CHECK_BATTERY:
-      this->await_response_("+CBC", State::CHECK_BATTERY_RESPONSE);
+      this->last_battery_check_ = millis();
+      this->await_(CommandId::CHECK_BATTERY, State::CHECK_BATTERY_RESPONSE);
       break;
 
-    case State::CHECK_BATTERY_RESPONSE: {
-      uint8_t bcs, percent;
-      uint16_t voltage;
-      get_response_param(this->command_state_.response, bcs, percent, voltage);
-      ESP_LOGI(TAG, "Battery: %d%%, %dmV", percent, voltage);
-      this->state_ = State::CHECK_PIN;
-#ifdef USE_SENSOR
-      if (this->battery_level_sensor_ != nullptr) {
-        this->battery_level_sensor_->publish_state(percent);
-      }
-      if (this->battery_voltage_sensor_ != nullptr) {
-        this->battery_voltage_sensor_->publish_state(voltage / 1000.0f);
-      }
-#endif
-    } break;
+    case State::CHECK_BATTERY_RESPONSE:
+      this->handle_battery_response_(this->command_state_.responses[0]);
+      this->state_ = this->initialized_ ? State::IDLE : State::CHECK_PIN;
+      break;
 
     case State::CHECK_PIN:
-      this->await_response_("+CPIN?", State::CHECK_PIN_RESPONSE, CHECK_PIN_TIMEOUT);
+      // Right after boot the SIM may not be ready yet, and the command fails
+      this->last_pin_check_ = millis();
+      this->await_(CommandId::CHECK_PIN, State::CHECK_PIN_RESPONSE, State::WAIT_SIM_READY);
       break;
 
-    case State::CHECK_PIN_RESPONSE: {
-      std::string code;
-      if (!this->command_state_.urc.empty()) {
-        get_response_param(this->command_state_.urc, code);
-      } else {
-        get_response_param(this->command_state_.response, code);
+    case State::WAIT_SIM_READY:
+      // Check again as soon as +CPIN: READY, Call Ready or SMS Ready is received
+      if (this->sim_ready_ || millis() - this->last_pin_check_ >= SIM_READY_POLL_INTERVAL) {
+        // A URC received before this check must not end the next wait right away
+        this->sim_ready_ = false;
+        this->state_ = State::CHECK_PIN;
       }
+      break;
+
+    case State::CHECK_PIN_RESPONSE: {
+      const std::string &response =
+          this->command_state_.urc_received() ? this->command_state_.urc : this->command_state_.responses[0];
+      std::string_view code;
+      parse_response(response, code);
 
       if (code == READY) {
+        // Bearer parameters can't be changed while the bearer is open
+        if (this->bearer_open_) {
+          this->state_ = State::ENABLE_REGISTRATION_URC;
+          goto ENABLE_REGISTRATION_URC;
+        }
         this->state_ = State::SET_CONTYPE_GRPS;
         goto SET_CONTYPE_GRPS;
       } else if (code == SIM_PIN) {
@@ -112,15 +375,18 @@ void Sim800LDataComponent::loop() {
           // Enter PIN. If it's correct, module will answer with OK and then URC "READY".
           // If it's wrong, module will simply answer with ERROR. In that case, do not try
           // again because after 3 tries the SIM will become locked with PUK.
-          const std::string cmd = str_concat("+CPIN=\"", this->pin_, "\"");
-          this->await_urc_(cmd, State::CHECK_PIN_RESPONSE, State::WRONG_PIN, CHECK_PIN_TIMEOUT, CHECK_PIN_TIMEOUT);
+          this->await_(CommandId::ENTER_PIN, State::CHECK_PIN_RESPONSE, State::WRONG_PIN, this->pin_.c_str());
         }
+      } else if (code == NOT_READY) {
+        ESP_LOGD(TAG, "SIM not ready yet");
+        this->sim_ready_ = false;
+        this->state_ = State::WAIT_SIM_READY;
       } else if (code == SIM_PUK) {
         ESP_LOGE(TAG, "SIM is locked with PUK. Use another device to unlock it.");
         this->state_ = State::INIT;
         this->wait_.start(FUTILE_WAIT);
       } else {
-        ESP_LOGE(TAG, "SIM is locked with status: %s", code.c_str());
+        ESP_LOGE(TAG, "SIM is locked with status: %s", response.c_str());
         this->state_ = State::INIT;
         this->wait_.start(FUTILE_WAIT);
       }
@@ -133,82 +399,194 @@ void Sim800LDataComponent::loop() {
 
     case State::SET_CONTYPE_GRPS:
     SET_CONTYPE_GRPS:
-      this->await_ok_("+SAPBR=3,1,\"CONTYPE\",\"GPRS\"", State::SET_APN);
+      this->await_(CommandId::SET_CONTYPE_GPRS, State::SET_APN);
       break;
 
     case State::SET_APN:
       if (!this->apn_.empty()) {
-        const std::string cmd = str_concat("+SAPBR=3,1,\"APN\",\"", this->apn_, "\"");
-        this->await_ok_(cmd, State::SET_APN_USER);
+        this->await_(CommandId::SET_APN, State::SET_APN_USER, State::INIT, this->apn_.c_str());
         break;
       }
       this->state_ = State::SET_APN_USER;
 
     case State::SET_APN_USER:
       if (!this->apn_user_.empty()) {
-        const std::string cmd = str_concat("+SAPBR=3,1,\"USER\",\"", this->apn_user_, "\"");
-        this->await_ok_(cmd, State::SET_APN_PWD);
+        this->await_(CommandId::SET_APN_USER, State::SET_APN_PWD, State::INIT, this->apn_user_.c_str());
         break;
       }
       this->state_ = State::SET_APN_PWD;
 
     case State::SET_APN_PWD:
       if (!this->apn_password_.empty()) {
-        const std::string cmd = str_concat("+SAPBR=3,1,\"PWD\",\"", this->apn_password_, "\"");
-        this->await_ok_(cmd, State::CHECK_REGISTRATION);
+        this->await_(CommandId::SET_APN_PWD, State::ENABLE_REGISTRATION_URC, State::INIT,
+                     this->apn_password_.c_str());
         break;
       }
-      this->state_ = State::CHECK_REGISTRATION;
+      this->state_ = State::ENABLE_REGISTRATION_URC;
+
+    case State::ENABLE_REGISTRATION_URC:
+    ENABLE_REGISTRATION_URC:
+      // Report registration changes as +CREG: <stat> URCs
+      this->await_(CommandId::ENABLE_REGISTRATION_URC, State::CHECK_REGISTRATION);
+      break;
 
     case State::CHECK_REGISTRATION:
-      this->await_response_("+CREG?", State::CHECK_REGISTRATION_RESPONSE);
+      this->last_registration_check_ = millis();
+      this->await_(CommandId::CHECK_REGISTRATION, State::CHECK_REGISTRATION_RESPONSE);
       break;
 
-    case State::CHECK_REGISTRATION_RESPONSE: {
-      uint8_t n, stat;
-      get_response_param(this->command_state_.response, n, stat);
-      if (stat != 1 && stat != 5) {
-        ESP_LOGE(TAG, "Not registered to network.");
-        this->state_ = State::INIT;
-        this->wait_.start(NOT_REGISTERED_WAIT);
+    case State::CHECK_REGISTRATION_RESPONSE:
+      if (!this->handle_registration_response_(this->command_state_.responses[0])) {
+        this->state_ = State::WAIT_REGISTRATION;
       } else {
-        this->state_ = State::CHECK_SIGNAL_QUALITY;
+        this->state_ = this->initialized_ ? State::IDLE : State::CHECK_SIGNAL_QUALITY;
       }
-    } break;
+      break;
+
+    case State::WAIT_REGISTRATION:
+      // Continue as soon as a +CREG URC reports the registration, the module is already set up
+      if (this->registered_) {
+        ESP_LOGI(TAG, "Registered to network");
+        this->state_ = this->initialized_ ? State::IDLE : State::CHECK_SIGNAL_QUALITY;
+      } else if (millis() - this->last_registration_check_ >= REGISTRATION_POLL_INTERVAL) {
+        this->state_ = State::CHECK_REGISTRATION;
+      }
+      break;
 
     case State::CHECK_SIGNAL_QUALITY:
-      this->await_response_("+CSQ", State::CHECK_SIGNAL_QUALITY_RESPONSE);
+      this->last_signal_check_ = millis();
+      this->await_(CommandId::CHECK_SIGNAL_QUALITY, State::CHECK_SIGNAL_QUALITY_RESPONSE);
       break;
 
-    case State::CHECK_SIGNAL_QUALITY_RESPONSE: {
-      uint8_t rssi;
-      get_response_param(this->command_state_.response, rssi);
-      const int8_t dbm = get_rssi_dbm(rssi);
-      ESP_LOGI(TAG, "RSSI: %d dBm", dbm);
+    case State::CHECK_SIGNAL_QUALITY_RESPONSE:
+      this->handle_signal_quality_response_(this->command_state_.responses[0]);
       this->state_ = State::IDLE;
-#ifdef USE_SENSOR
-      if (this->signal_strength_sensor_ != nullptr) {
-        this->signal_strength_sensor_->publish_state(dbm);
+      if (!this->initialized_) {
+        ESP_LOGI(TAG, "Initialization finished");
+        this->initialized_ = true;
       }
-#endif
-    } break;
+      break;
 
-    case State::IDLE:
-      // If there is a pending http request, start it now
-      if (this->http_state_.state == HttpState::QUEUED) {
-        // If idle_sleep is active, INIT first. This will disable idle_sleep
-        // and we will reach this point again after INIT.
-        if (idle_sleep_active_) {
-          goto INIT;
-        } else {
-          goto HTTP_INIT;
-        }
+    case State::CHECK_STATUS_RESPONSE: {
+      // Responses of the combined status checks sent from IDLE
+      const CommandState &cmd = this->command_state_;
+      this->state_ = State::IDLE;
+      const std::string *response = cmd.response_of(CommandId::CHECK_BATTERY);
+      if (response != nullptr) {
+        this->handle_battery_response_(*response);
       }
-      // If nothing to do, start idle sleep if configured
-      else if (this->idle_sleep_ && !idle_sleep_active_) {
-        goto ENABLE_SLEEP;
+      response = cmd.response_of(CommandId::CHECK_SIGNAL_QUALITY);
+      if (response != nullptr) {
+        this->handle_signal_quality_response_(*response);
       }
-      break;
+      response = cmd.response_of(CommandId::CHECK_REGISTRATION);
+      if (response != nullptr && !this->handle_registration_response_(*response)) {
+        // The module is still set up, only wait for the network
+        this->state_ = State::WAIT_REGISTRATION;
+      }
+    } break;
+
+    case State::IDLE: {
+      // IDLE starts one job at a time, chosen by next_idle_job_(). Jobs that send commands
+      // WAKE first if idle sleep is active. This disables idle sleep and we get back here after WAKE.
+      const uint32_t now = millis();
+      switch (this->next_idle_job_(now)) {
+        case IdleJob::REGISTRATION_LOST:
+          // Registration was lost according to a +CREG URC. The module is still set up, so wait
+          // for the next URC and poll +CREG? meanwhile.
+          if (idle_sleep_active_) {
+            goto WAKE;
+          }
+          this->last_registration_check_ = now;
+          this->state_ = State::WAIT_REGISTRATION;
+          break;
+
+        case IdleJob::SOCKET:
+          // Connect or close the socket, send queued data or fetch received data
+          if (idle_sleep_active_) {
+            goto WAKE;
+          }
+          if (this->socket_status_ == SocketStatus::CONNECT_REQUESTED) {
+            this->socket_status_ = SocketStatus::CONNECTING;
+            this->state_ = State::SOCKET_SHUT;
+          } else if (this->socket_status_ == SocketStatus::CLOSE_REQUESTED) {
+            this->state_ = State::SOCKET_CLOSE;
+          } else if (this->socket_rx_pending_) {
+            this->state_ = State::SOCKET_RECEIVE;
+          } else {
+            this->state_ = State::SOCKET_SEND;
+          }
+          break;
+
+        case IdleJob::KEEP_ALIVE:
+          // Write queued GET requests to the keep-alive connection
+          if (idle_sleep_active_) {
+            goto WAKE;
+          }
+          this->state_ = State::HTTP_KEEP_ALIVE;
+          break;
+
+        case IdleJob::HTTP_REQUEST:
+          // Start sending the queued http requests
+          memset(this->state_time_, 0, sizeof(this->state_time_));
+          if (idle_sleep_active_) {
+            goto WAKE;
+          } else if (this->bearer_open_) {
+            goto HTTP_CHECK_BEARER;
+          } else {
+            goto HTTP_INIT;
+          }
+
+        case IdleJob::OVERDUE_CHECKS:
+        case IdleJob::CHECKS: {
+          // Warm path: only run the checks that are due, combined on one command line
+          if (idle_sleep_active_) {
+            goto WAKE;
+          }
+          CommandId checks[MAX_COMBINED_COMMANDS];
+          const uint8_t count = this->due_checks_(now, 1, checks);
+          for (uint8_t i = 0; i < count; i++) {
+            if (checks[i] == CommandId::CHECK_BATTERY) {
+              this->last_battery_check_ = now;
+            } else if (checks[i] == CommandId::CHECK_SIGNAL_QUALITY) {
+              this->last_signal_check_ = now;
+            } else {
+              this->last_registration_check_ = now;
+            }
+          }
+          this->await_combined_(checks, count, State::CHECK_STATUS_RESPONSE, State::INIT);
+        } break;
+
+        case IdleJob::BEARER_CLOSE:
+          // Close a kept open bearer after it has been idle for too long
+          if (idle_sleep_active_) {
+            goto WAKE;
+          }
+          ESP_LOGD(TAG, "Bearer idle for %u ms, closing", now - this->bearer_idle_since_);
+          this->state_ = State::HTTP_TERM;
+          break;
+
+        case IdleJob::OUTBOX:
+          // Send the stored outbox entries in one request
+          this->flush_outbox_();
+          break;
+
+        case IdleJob::KEEP_ALIVE_CLOSE:
+          // Close the keep-alive connection when it is idle, or when the server stopped answering
+          if (this->keep_alive_sent_ > 0) {
+            ESP_LOGE(TAG, "No HTTP response for %u ms, closing connection", now - this->keep_alive_activity_);
+          }
+          this->socket_close_();
+          break;
+
+        case IdleJob::SLEEP:
+          // If nothing to do, start idle sleep if configured
+          goto ENABLE_SLEEP;
+
+        case IdleJob::NONE:
+          break;
+      }
+    } break;
 
     case State::FATAL:
       ESP_LOGE(TAG, "Fatal error.");
@@ -217,55 +595,147 @@ void Sim800LDataComponent::loop() {
 
     case State::ENABLE_SLEEP:
     ENABLE_SLEEP:
+      if (this->dtr_pin_ != nullptr) {
+        // With +CSCLK=1 the module sleeps while DTR is high. It is only sent once,
+        // after that the module is put to sleep by setting DTR.
+        if (!this->dtr_sleep_enabled_) {
+          this->dtr_sleep_enabled_ = true;
+          this->await_(CommandId::ENABLE_DTR_SLEEP, State::ENABLE_SLEEP);
+          break;
+        }
+        this->dtr_pin_->digital_write(true);
+        this->idle_sleep_active_ = true;
+        this->state_ = State::IDLE;
+        break;
+      }
       // Enable auto sleep. To wake the module, AT must be sent.
-      this->await_ok_("+CSCLK=2", State::IDLE);
+      this->await_(CommandId::ENABLE_SLEEP, State::IDLE);
       this->idle_sleep_active_ = true;
       break;
 
+    case State::HTTP_CHECK_BEARER:
+    HTTP_CHECK_BEARER:
+      // A kept open bearer is checked with a cheap status query instead of being reopened.
+      this->await_(CommandId::BEARER_STATUS, State::HTTP_CHECK_BEARER_RESPONSE, State::HTTP_INIT);
+      break;
+
+    case State::HTTP_CHECK_BEARER_RESPONSE: {
+      // Example response: +SAPBR: 1,1,"10.0.0.1"
+      uint8_t cid, status;
+      if (parse_response(this->command_state_.responses[0], cid, status) && status == 1) {
+        goto HTTP_START_REQUEST;
+      }
+      ESP_LOGW(TAG, "Bearer was closed, reopening: %s", this->command_state_.responses[0].c_str());
+      this->state_ = State::HTTP_INIT;
+    } break;
+
     case State::HTTP_INIT:
     HTTP_INIT:
+      // The bearer is opened once and then used by all queued requests.
       // Ignore failure. Assume that HTTP is already initialized.
       // If it's not, the next command will fail anyway.
-      this->http_state_.state = HttpState::PENDING;
-      this->await_ok_("+HTTPINIT", State::HTTP_SET_SSL, State::HTTP_SET_SSL);
-      break;
-
-    case State::HTTP_SET_SSL:
-      this->await_ok_("+HTTPSSL=" + to_string(this->http_state_.ssl), State::HTTP_SET_BEARER, State::HTTP_FAILED);
+      this->bearer_open_ = false;
+      this->await_(CommandId::HTTP_INIT, State::HTTP_SET_BEARER, State::HTTP_SET_BEARER);
       break;
 
     case State::HTTP_SET_BEARER:
-      this->await_ok_("+HTTPPARA=\"CID\",1", State::HTTP_OPEN_BEARER, State::HTTP_FAILED);
+      this->await_(CommandId::HTTP_SET_BEARER, State::HTTP_OPEN_BEARER, State::HTTP_FAILED);
       break;
 
     case State::HTTP_OPEN_BEARER:
-      this->await_ok_("+SAPBR=1,1", State::HTTP_SET_URL, State::HTTP_FAILED, BEARER_OPEN_TIMEOUT);
+      this->await_(CommandId::BEARER_OPEN, State::HTTP_START_REQUEST, State::HTTP_FAILED);
+      break;
+
+    case State::HTTP_START_REQUEST:
+    HTTP_START_REQUEST: {
+      this->bearer_open_ = true;
+      this->start_http_request_(this->http_queue_.front());
+      this->state_ = State::HTTP_SET_SSL;
+      goto HTTP_SET_SSL;
+    } break;
+
+    case State::HTTP_SET_SSL:
+    HTTP_SET_SSL:
+      this->await_(CommandId::HTTP_SET_SSL, State::HTTP_SET_URL, State::HTTP_FAILED,
+                   this->http_queue_.front().ssl ? "1" : "0");
       break;
 
     case State::HTTP_SET_URL: {
-      const std::string cmd = str_concat("+HTTPPARA=\"URL\",\"", this->http_state_.url, "\"");
-      this->await_ok_(cmd, State::HTTP_ACTION, State::HTTP_FAILED);
+      const HttpRequest &request = this->http_queue_.front();
+      const State next_state = request.method == HttpRequest::POST ? State::HTTP_SET_CONTENT : State::HTTP_ACTION;
+      this->await_(CommandId::HTTP_SET_URL, next_state, State::HTTP_FAILED, request.url.c_str());
+    } break;
+
+    case State::HTTP_SET_CONTENT: {
+      const HttpRequest &request = this->http_queue_.front();
+      const State next_state = request.body_size > 0 ? State::HTTP_DATA : State::HTTP_ACTION;
+      this->await_(CommandId::HTTP_SET_CONTENT, next_state, State::HTTP_FAILED, request.content_type.c_str());
+    } break;
+
+    case State::HTTP_DATA: {
+      // The module answers with DOWNLOAD, then expects exactly body_size bytes.
+      HttpRequest &request = this->http_queue_.front();
+      request.body_offset = 0;
+      request.body_failed = false;
+      char argument[24];
+      snprintf(argument, sizeof(argument), "%u,%u", request.body_size, HTTP_DATA_INPUT_TIMEOUT);
+      this->await_(CommandId::HTTP_DATA, State::HTTP_WRITE_BODY, State::HTTP_FAILED, argument);
+    } break;
+
+    case State::HTTP_WRITE_BODY: {
+      // Write one chunk per loop, so other components are not blocked by large bodies.
+      HttpRequest &request = this->http_queue_.front();
+      if (request.body_offset < request.body_size) {
+        uint8_t buffer[HTTP_BODY_CHUNK_SIZE];
+        const uint32_t remaining = request.body_size - request.body_offset;
+        const size_t length = remaining > sizeof(buffer) ? sizeof(buffer) : remaining;
+        size_t written = 0;
+        if (!request.body_failed) {
+          written = request.body_provider(request.body_offset, buffer, length);
+          if (written == 0 || written > length) {
+            // The module takes everything up to body_size as body, also the next commands.
+            // Pad the rest, and fail the request once the module is back in command mode.
+            ESP_LOGE(TAG, "Body provider returned %u bytes at offset %u, expected %u", (unsigned) written,
+                     request.body_offset, (unsigned) length);
+            request.body_failed = true;
+          }
+        }
+        if (request.body_failed) {
+          memset(buffer, ' ', length);
+          written = length;
+        }
+        ESP_LOGV(TAG, "<-- %u bytes of body", (unsigned) written);
+        this->write_array(buffer, written);
+        request.body_offset += written;
+        break;
+      }
+      this->await_input_ok_(CommandId::HTTP_DATA, request.body_failed ? State::HTTP_FAILED : State::HTTP_ACTION,
+                            State::HTTP_FAILED, HTTP_DATA_INPUT_TIMEOUT);
     } break;
 
     case State::HTTP_ACTION:
-      this->await_urc_("+HTTPACTION=0", State::HTTP_ACTION_RESPONSE, State::HTTP_FAILED, HTTP_ACTION_TIMEOUT,
-                       DEFAULT_URC_TIMEOUT);
+      this->await_(CommandId::HTTP_ACTION, State::HTTP_ACTION_RESPONSE, State::HTTP_FAILED,
+                   this->http_queue_.front().method == HttpRequest::POST ? "1" : "0");
       break;
 
     case State::HTTP_ACTION_RESPONSE: {
+      HttpRequest &request = this->http_queue_.front();
       uint8_t method;
       uint16_t status_code;
       uint32_t length;
-      get_response_param(this->command_state_.urc, method, status_code, length);
+      if (!parse_response(this->command_state_.urc, method, status_code, length)) {
+        ESP_LOGE(TAG, "Invalid response: %s", this->command_state_.urc.c_str());
+        goto HTTP_FAILED;
+      }
 
-      this->http_state_.status_code = status_code;
+      request.status_code = status_code;
 
       // Status codes in the 600 range are errors of the module
       if (status_code >= 600 && status_code <= 699) {
         goto HTTP_FAILED;
       }
 
-      ESP_LOGI(TAG, "HTTP request succeeded: %d %s", status_code, this->http_state_.url.c_str());
+      ESP_LOGI(TAG, "HTTP request succeeded: %d %s", status_code, request.url.c_str());
 
       // If length is 0, we don't need to send a HTTPREAD command and
       // can directly trigger http request done
@@ -274,88 +744,365 @@ void Sim800LDataComponent::loop() {
         goto HTTP_READ_RESPONSE;
       }
 
+      // In streaming mode, the body is read in windows of response_chunk_size
+      if (this->stream_response_) {
+        request.content_length = length;
+        request.read_offset = 0;
+        goto HTTP_READ_CHUNK;
+      }
+
       if (length > MAX_HTTP_RESPONSE_SIZE) {
         ESP_LOGW(TAG, "Response body is too big, truncating to %d bytes", MAX_HTTP_RESPONSE_SIZE);
         length = MAX_HTTP_RESPONSE_SIZE;
       }
-      this->await_data_("+HTTPREAD", length, State::HTTP_READ_RESPONSE, State::HTTP_FAILED);
+      this->await_data_(CommandId::HTTP_READ, nullptr, length, State::HTTP_READ_RESPONSE, State::HTTP_FAILED);
     } break;
 
     case State::HTTP_READ_RESPONSE: {
     HTTP_READ_RESPONSE:
-      this->http_state_.response_data = std::move(this->command_state_.data);
-      this->http_request_done_callback_.call(this->http_state_.status_code, this->http_state_.response_data);
-      this->http_state_.reset();
-      this->state_ = State::HTTP_TERM;
+      // The body is passed directly from the command buffer, so it keeps its capacity
+      this->deliver_http_response_(this->http_queue_.front().status_code, this->command_state_.data);
+      this->state_ = State::HTTP_NEXT_REQUEST;
+      goto HTTP_NEXT_REQUEST;
+    } break;
+
+    case State::HTTP_READ_CHUNK:
+    HTTP_READ_CHUNK: {
+      HttpRequest &request = this->http_queue_.front();
+      const uint32_t remaining = request.content_length - request.read_offset;
+      const uint32_t length = remaining > this->response_chunk_size_ ? this->response_chunk_size_ : remaining;
+      char argument[24];
+      snprintf(argument, sizeof(argument), "%u,%u", request.read_offset, length);
+      this->await_data_(CommandId::HTTP_READ_RANGE, argument, length, State::HTTP_READ_CHUNK_RESPONSE,
+                        State::HTTP_FAILED);
+    } break;
+
+    case State::HTTP_READ_CHUNK_RESPONSE: {
+      HttpRequest &request = this->http_queue_.front();
+      this->deliver_http_chunk_(request.read_offset, this->command_state_.data);
+      request.read_offset += this->command_state_.data.size();
+      if (request.read_offset < request.content_length) {
+        goto HTTP_READ_CHUNK;
+      }
+      ESP_LOGD(TAG, "Streamed %u bytes of response body", request.read_offset);
+      // The body has been delivered in chunks, the done callback gets an empty body
+      this->command_state_.data.clear();
+      this->deliver_http_response_(request.status_code, this->command_state_.data);
+      this->state_ = State::HTTP_NEXT_REQUEST;
+      goto HTTP_NEXT_REQUEST;
     } break;
 
     case State::HTTP_FAILED:
     HTTP_FAILED:
-      ESP_LOGE(TAG, "HTTP request failed: %s", this->http_state_.url.c_str());
+      ESP_LOGE(TAG, "HTTP request failed: %s", this->http_queue_.front().url.c_str());
+      this->state_ = State::HTTP_NEXT_REQUEST;
+      this->http_request_failed_();
+      // fall through
+
+    case State::HTTP_NEXT_REQUEST:
+    HTTP_NEXT_REQUEST: {
+      this->finish_http_request_();
+      const uint32_t now = millis();
+
+      // Send the next request over the same bearer. If the bearer could not be
+      // opened, close the session; the remaining requests are retried from IDLE.
+      // Overdue checks are run from IDLE first, the bearer stays open for them.
+      CommandId checks[MAX_COMBINED_COMMANDS];
+      if (this->bearer_open_ && this->http_request_startable_(now)) {
+        if (this->due_checks_(now, CHECK_DEADLINE_INTERVALS, checks) > 0) {
+          this->bearer_idle_since_ = now;
+          this->state_ = State::IDLE;
+          break;
+        }
+        ESP_LOGD(TAG, "Sending next HTTP request, %u queued", (unsigned) this->http_queue_.size());
+        goto HTTP_START_REQUEST;
+      }
+      // Keep the bearer and HTTP session for the next request if configured, and for requests
+      // that wait for http_min_interval
+      if (this->bearer_open_ && (this->keep_bearer_open_ > 0 || this->http_request_deferred_(now))) {
+        this->bearer_idle_since_ = now;
+        this->state_ = State::IDLE;
+        break;
+      }
       this->state_ = State::HTTP_TERM;
-      this->http_request_failed_callback_.call();
-      this->http_state_.reset();
-      break;
+    } break;
 
     case State::HTTP_TERM:
-      this->await_ok_("+HTTPTERM", State::HTTP_CLOSE_BEARER, State::HTTP_CLOSE_BEARER);
+      this->await_(CommandId::HTTP_TERM, State::HTTP_CLOSE_BEARER, State::HTTP_CLOSE_BEARER);
       break;
 
     case State::HTTP_CLOSE_BEARER:
-      this->await_ok_("+SAPBR=0,1", State::IDLE, State::INIT, BEARER_CLOSE_TIMEOUT);
+      this->bearer_open_ = false;
+      this->await_(CommandId::BEARER_CLOSE, State::IDLE, State::INIT);
+      break;
+
+    case State::HTTP_KEEP_ALIVE: {
+      // Write all queued GET requests to the same host back to back, as one AT+CIPSEND
+      this->state_ = State::IDLE;
+      std::string_view host, path;
+      uint16_t port;
+      parse_http_url(this->http_queue_.at(this->keep_alive_sent_).url, host, port, path);
+      if (this->socket_status_ == SocketStatus::CLOSED) {
+        this->socket_connect(SocketProtocol::TCP, std::string(host), port);
+        this->socket_keep_alive_ = true;
+        this->keep_alive_parser_.reset();
+        break;
+      }
+      if (host != this->socket_host_ || port != this->socket_port_) {
+        ESP_LOGD(TAG, "Next request is for another host, closing connection");
+        this->socket_close_();
+        break;
+      }
+
+      std::string payload;
+      size_t index = this->keep_alive_sent_;
+      while (index < this->http_queue_.size()) {
+        HttpRequest &request = this->http_queue_.at(index);
+        if (!this->use_keep_alive_(request) || !this->http_request_ready_(request, millis()) ||
+            !parse_http_url(request.url, host, port, path) ||
+            host != this->socket_host_ || port != this->socket_port_) {
+          break;
+        }
+        char port_suffix[8] = "";
+        if (port != 80) {
+          snprintf(port_suffix, sizeof(port_suffix), ":%u", port);
+        }
+        const size_t start = payload.size();
+        payload.append("GET ").append(path).append(" HTTP/1.1\r\nHost: ").append(host).append(port_suffix);
+        payload.append("\r\nConnection: keep-alive\r\n\r\n");
+        if (payload.size() > SOCKET_MAX_SEND_SIZE) {
+          payload.resize(start);
+          break;
+        }
+        this->start_http_request_(request);
+        index++;
+      }
+      if (payload.empty()) {
+        // A single request that does not fit into one AT+CIPSEND. Only this one fails,
+        // the requests before it are still waiting for their responses.
+        ESP_LOGE(TAG, "HTTP request too long for keep-alive: %s",
+                 this->http_queue_.at(this->keep_alive_sent_).url.c_str());
+        this->http_request_failed_(this->keep_alive_sent_);
+        this->finish_http_request_(this->keep_alive_sent_);
+        break;
+      }
+      ESP_LOGD(TAG, "Writing %u HTTP requests to %s:%u", (unsigned) (index - this->keep_alive_sent_),
+               this->socket_host_.c_str(), this->socket_port_);
+      this->socket_send_(std::move(payload));
+      this->keep_alive_sent_ = index;
+      this->keep_alive_activity_ = millis();
+    } break;
+
+    case State::SOCKET_SHUT:
+      // Reset the IP stack, it only accepts AT+CSTT in the initial state
+      this->await_(CommandId::SOCKET_SHUT, State::SOCKET_MANUAL_RECEIVE, State::SOCKET_FAILED);
+      break;
+
+    case State::SOCKET_MANUAL_RECEIVE:
+      // Received data is announced with +CIPRXGET: 1 and fetched with AT+CIPRXGET=2
+      this->await_(CommandId::SOCKET_MANUAL_RECEIVE, State::SOCKET_SET_APN, State::SOCKET_FAILED);
+      break;
+
+    case State::SOCKET_SET_APN: {
+      // e.g. AT+CSTT="apn","user","password"
+      const std::string argument = this->apn_ + "\",\"" + this->apn_user_ + "\",\"" + this->apn_password_;
+      this->await_(CommandId::SOCKET_SET_APN, State::SOCKET_BRING_UP, State::SOCKET_FAILED, argument.c_str());
+    } break;
+
+    case State::SOCKET_BRING_UP:
+      this->await_(CommandId::SOCKET_BRING_UP, State::SOCKET_GET_IP, State::SOCKET_FAILED);
+      break;
+
+    case State::SOCKET_GET_IP:
+      // Required before AT+CIPSTART, even though the address is not used
+      this->await_(CommandId::SOCKET_GET_IP, State::SOCKET_CONNECT, State::SOCKET_FAILED);
+      break;
+
+    case State::SOCKET_CONNECT: {
+      // e.g. AT+CIPSTART="TCP","example.com",1234
+      char port[8];
+      snprintf(port, sizeof(port), "%u", this->socket_port_);
+      const std::string argument = std::string(this->socket_protocol_ == SocketProtocol::UDP ? "\"UDP\"" : "\"TCP\"") +
+                                   ",\"" + this->socket_host_ + "\"," + port;
+      this->await_(CommandId::SOCKET_CONNECT, State::SOCKET_CONNECTED, State::SOCKET_FAILED, argument.c_str());
+    } break;
+
+    case State::SOCKET_CONNECTED:
+      ESP_LOGI(TAG, "Socket connected to %s:%u", this->socket_host_.c_str(), this->socket_port_);
+      this->socket_status_ = SocketStatus::CONNECTED;
+      this->state_ = State::IDLE;
+      if (this->socket_keep_alive_) {
+        this->keep_alive_activity_ = millis();
+      } else {
+        this->socket_connected_callback_.call();
+      }
+      break;
+
+    case State::SOCKET_SEND: {
+      char argument[8];
+      snprintf(argument, sizeof(argument), "%u", (unsigned) this->socket_tx_queue_.front().size());
+      this->await_(CommandId::SOCKET_SEND, State::SOCKET_WRITE_DATA, State::SOCKET_FAILED, argument);
+    } break;
+
+    case State::SOCKET_WRITE_DATA: {
+      const std::string &data = this->socket_tx_queue_.front();
+      ESP_LOGV(TAG, "<-- %u bytes of socket data", (unsigned) data.size());
+      this->write_array(reinterpret_cast<const uint8_t *>(data.data()), data.size());
+      this->await_input_ok_(CommandId::SOCKET_SEND_DATA, State::SOCKET_SENT, State::SOCKET_FAILED,
+                            DEFAULT_COMMAND_TIMEOUT);
+    } break;
+
+    case State::SOCKET_SENT:
+      this->socket_tx_queue_.pop_front();
+      this->state_ = State::IDLE;
+      break;
+
+    case State::SOCKET_RECEIVE: {
+      char argument[8];
+      snprintf(argument, sizeof(argument), "%u", SOCKET_RECEIVE_SIZE);
+      this->await_data_(CommandId::SOCKET_RECEIVE, argument, SOCKET_RECEIVE_SIZE, State::SOCKET_RECEIVE_RESPONSE,
+                        State::SOCKET_FAILED);
+    } break;
+
+    case State::SOCKET_RECEIVE_RESPONSE: {
+      // Example response: +CIPRXGET: 2,<length>,<bytes left>
+      uint8_t mode;
+      uint16_t length, left;
+      this->state_ = State::IDLE;
+      if (!parse_response(this->command_state_.responses[0], mode, length, left)) {
+        ESP_LOGW(TAG, "Invalid response: %s", this->command_state_.responses[0].c_str());
+        left = 0;
+      }
+      this->socket_rx_pending_ = left > 0;
+      if (this->socket_keep_alive_) {
+        this->handle_keep_alive_data_(this->command_state_.data);
+      } else if (!this->command_state_.data.empty()) {
+        this->deliver_socket_data_(this->command_state_.data);
+      }
+    } break;
+
+    case State::SOCKET_FAILED:
+      ESP_LOGE(TAG, "Socket to %s:%u failed", this->socket_host_.c_str(), this->socket_port_);
+      this->state_ = State::SOCKET_SHUT_GPRS;
+      goto SOCKET_SHUT_GPRS;
+
+    case State::SOCKET_CLOSE:
+      // Fails if the remote side has closed the connection already
+      this->await_(CommandId::SOCKET_CLOSE, State::SOCKET_SHUT_GPRS, State::SOCKET_SHUT_GPRS);
+      break;
+
+    case State::SOCKET_SHUT_GPRS:
+    SOCKET_SHUT_GPRS:
+      // Deactivate the GPRS context of the IP stack. The HTTP bearer is not affected.
+      this->await_(CommandId::SOCKET_SHUT, State::SOCKET_CLOSED, State::SOCKET_CLOSED);
+      break;
+
+    case State::SOCKET_CLOSED: {
+      ESP_LOGI(TAG, "Socket closed");
+      const bool connected = this->socket_status_ != SocketStatus::CONNECTING;
+      this->socket_status_ = SocketStatus::CLOSED;
+      this->socket_rx_pending_ = false;
+      this->socket_tx_queue_.clear();
+      this->state_ = State::IDLE;
+      if (this->socket_keep_alive_) {
+        this->keep_alive_closed_(connected);
+      } else {
+        this->socket_closed_callback_.call();
+      }
+    } break;
+  }
+}
+
+void Sim800LDataComponent::fill_rx_buffer_() {
+  size_t available = this->available();
+  // If the driver buffer is full, bytes were most likely lost because loop() ran too late
+  if (available >= this->parent_->get_rx_buffer_size()) {
+    this->rx_overruns_++;
+  }
+  while (available > 0 && this->rx_buffer_.free() > 0) {
+    const size_t length = std::min(available, this->rx_buffer_.write_length());
+    if (!this->read_array(this->rx_buffer_.write_ptr(), length)) {
       break;
+    }
+    this->rx_buffer_.commit(length);
+    this->rx_bytes_ += length;
+    available -= length;
   }
 }
 
 bool Sim800LDataComponent::read_line_() {
-  while (this->available()) {
-    if (this->read_buffer_.size() >= MAX_READ_BUFFER_SIZE) {
-      ESP_LOGE(TAG, "Read buffer full, purging");
-      this->read_buffer_.clear();
-      this->read_buffer_.shrink_to_fit();
+  this->fill_rx_buffer_();
+
+  while (!this->rx_buffer_.empty()) {
+    const int length = this->rx_buffer_.find(LF);
+    if (length < 0) {
+      if (this->rx_buffer_.size() >= MAX_READ_BUFFER_SIZE) {
+        ESP_LOGE(TAG, "Read buffer full, purging");
+        this->rx_buffer_.clear();
+        this->rx_purges_++;
+      }
+      return false;
+    }
+    if (length >= MAX_READ_BUFFER_SIZE) {
+      ESP_LOGE(TAG, "Line too long, purging");
+      this->rx_buffer_.drop(length + 1);
+      this->rx_purges_++;
       continue;
     }
 
-    uint8_t byte;
-    this->read_byte(&byte);
-    ESP_LOGVV(TAG, "--> %02X", byte);
+    this->rx_buffer_.pop(this->read_buffer_, length);
+    this->rx_buffer_.drop(1);
 
     // Ignore \r and \0
-    if (byte == CR || byte == 0) {
-      continue;
-    }
+    this->read_buffer_.erase(
+        std::remove_if(this->read_buffer_.begin(), this->read_buffer_.end(), [](char c) { return c == CR || c == 0; }),
+        this->read_buffer_.end());
 
-    if (byte == LF) {
-      // ignore empty lines
-      if (this->read_buffer_.empty()) {
-        continue;
-      }
-      ESP_LOGV(TAG, "--> %s", this->read_buffer_.c_str());
-      return true;
+    // ignore empty lines
+    if (this->read_buffer_.empty()) {
+      continue;
     }
-
-    this->read_buffer_ += static_cast<char>(byte);
+    ESP_LOGV(TAG, "--> %s", this->read_buffer_.c_str());
+    return true;
   }
   return false;
 }
 
-bool Sim800LDataComponent::read_bytes_(const uint16_t length) {
-  const uint16_t to_read = length > MAX_READ_BUFFER_SIZE ? MAX_READ_BUFFER_SIZE : length;
+bool Sim800LDataComponent::read_prompt_(const char *prompt) {
+  this->fill_rx_buffer_();
 
-  while (this->available() && this->read_buffer_.size() < to_read) {
-    uint8_t byte;
-    this->read_byte(&byte);
-    ESP_LOGVV(TAG, "--> %02X", byte);
-
-    // Replace \0 with space because it would terminate the string,
-    // but keep the data length same.
-    if (byte == 0) {
-      byte = ' ';
+  // Skip the line break before the prompt
+  while (!this->rx_buffer_.empty() && (this->rx_buffer_.at(0) == CR || this->rx_buffer_.at(0) == LF)) {
+    this->rx_buffer_.drop(1);
+  }
+  const size_t length = strlen(prompt);
+  if (this->rx_buffer_.size() < length) {
+    return false;
+  }
+  for (size_t i = 0; i < length; i++) {
+    if (this->rx_buffer_.at(i) != prompt[i]) {
+      return false;
     }
+  }
+  ESP_LOGV(TAG, "--> %s", prompt);
+  this->rx_buffer_.drop(length);
+  // "> " ends with a space
+  if (!this->rx_buffer_.empty() && this->rx_buffer_.at(0) == ' ') {
+    this->rx_buffer_.drop(1);
+  }
+  return true;
+}
 
-    this->read_buffer_ += static_cast<char>(byte);
+bool Sim800LDataComponent::read_bytes_(std::string &out, const uint32_t length) {
+  this->fill_rx_buffer_();
+
+  const size_t to_read = std::min<size_t>(length, this->rx_buffer_.size());
+  if (to_read == 0) {
+    return false;
   }
-  return !this->read_buffer_.empty();
+  this->rx_buffer_.pop(out, to_read);
+  ESP_LOGVV(TAG, "--> %u bytes", (unsigned) to_read);
+  return true;
 }
 
 bool Sim800LDataComponent::handle_response_() {
@@ -369,23 +1116,29 @@ bool Sim800LDataComponent::handle_response_() {
   // we call read_data_ so that line breaks are not filtered out.
   if (cmd.is_pending && cmd.data_required > 0 && cmd.response_received() && !cmd.data_complete()) {
     const uint32_t data_left = cmd.data_required - cmd.data.size();
-    const bool data_read = this->read_bytes_(data_left);
+    const bool data_read = this->read_bytes_(cmd.data, data_left);
 
-    if (data_read) {
-      cmd.data += this->read_buffer_;
-      this->read_buffer_.clear();
-      this->read_buffer_.shrink_to_fit();
-    } else if (cmd.timed_out()) {
-      ESP_LOGE(TAG, "Command \"AT%s\" timed out after %d ms", cmd.command.c_str(), cmd.runtime());
-      cmd.is_pending = false;
-      this->state_ = cmd.error_state;
+    if (!data_read && cmd.timed_out()) {
+      ESP_LOGE(TAG, "Command \"AT%s\" timed out after %d ms", cmd.command->text, cmd.runtime());
+      this->finish_command_(CommandResult::TIMEOUT);
     }
     return false;
   }
 
+  if (cmd.is_pending && cmd.prompt_required && this->read_prompt_(cmd.command->prefix)) {
+    this->finish_command_(CommandResult::SUCCESS);
+    ESP_LOGI(TAG, "Command \"AT%s\" received %s after %d ms", cmd.command->text, cmd.command->prefix,
+             cmd.runtime());
+    return true;
+  }
+
   const bool read = this->read_line_();
   if (read) {
     if (!cmd.is_pending) {
+      if (this->dispatch_urc_(this->read_buffer_)) {
+        this->read_buffer_.clear();
+        return false;
+      }
       ESP_LOGV(TAG, "Ignoring: \"%s\"", this->read_buffer_.c_str());
       this->read_buffer_.clear();
       return false;
@@ -403,61 +1156,68 @@ bool Sim800LDataComponent::handle_response_() {
       cmd.ok_received = true;
 
       if (cmd.response_required && !cmd.response_received()) {
-        ESP_LOGE(TAG, "Command \"AT%s\" failed: missing response", cmd.command.c_str());
-        cmd.is_pending = false;
-        this->state_ = cmd.error_state;
+        ESP_LOGE(TAG, "Command \"AT%s\" failed: missing response", cmd.command->text);
+        this->finish_command_(CommandResult::ERROR);
         return false;
       }
 
       if (cmd.data_required > 0 && !cmd.data_complete()) {
-        ESP_LOGE(TAG, "Command \"AT%s\" failed: missing data", cmd.command.c_str());
-        cmd.is_pending = false;
-        this->state_ = cmd.error_state;
+        ESP_LOGE(TAG, "Command \"AT%s\" failed: missing data", cmd.command->text);
+        this->finish_command_(CommandResult::ERROR);
         return false;
       }
 
       if (cmd.urc_required) {
-        ESP_LOGI(TAG, "Command \"AT%s\" received OK, waiting for URC", cmd.command.c_str());
+        ESP_LOGI(TAG, "Command \"AT%s\" received OK, waiting for URC", cmd.command->text);
         return false;
       }
 
-      cmd.is_pending = false;
-      this->state_ = cmd.success_state;
-      ESP_LOGI(TAG, "Command \"AT%s\" succeeded after %d ms", cmd.command.c_str(), cmd.runtime());
+      this->finish_command_(CommandResult::SUCCESS);
+      ESP_LOGI(TAG, "Command \"AT%s\" succeeded after %d ms", cmd.command->text, cmd.runtime());
       return true;
     }
 
-    if (this->read_buffer_ == ERROR) {
+    if (this->read_buffer_ == ERROR || this->read_buffer_ == CONNECT_FAIL || this->read_buffer_ == SEND_FAIL) {
       this->read_buffer_.clear();
-      ESP_LOGE(TAG, "Command \"AT%s\" failed after %d ms", cmd.command.c_str(), cmd.runtime());
-      cmd.is_pending = false;
-      this->state_ = cmd.error_state;
+      ESP_LOGE(TAG, "Command \"AT%s\" failed after %d ms", cmd.command->text, cmd.runtime());
+      this->finish_command_(CommandResult::ERROR);
       return false;
     }
 
-    if (cmd.response_required && !cmd.response_received() && is_response_or_urc(cmd.command, this->read_buffer_)) {
-      cmd.response = std::move(this->read_buffer_);
+    if (cmd.response_required && cmd.add_response(this->read_buffer_)) {
       this->read_buffer_.clear();
 
+      // The length of received socket data is only known from the response: +CIPRXGET: 2,<length>,<left>
+      if (cmd.command->id == CommandId::SOCKET_RECEIVE) {
+        uint8_t mode;
+        uint16_t length;
+        cmd.data_required =
+            parse_response(cmd.responses[0], mode, length) ? std::min<uint32_t>(length, cmd.data_required) : 0;
+      }
+
       if (cmd.data_required > 0) {
-        ESP_LOGI(TAG, "Command \"AT%s\" received response, waiting for data", cmd.command.c_str());
+        ESP_LOGI(TAG, "Command \"AT%s\" received response, waiting for data", cmd.command->text);
         return false;
       }
 
-      ESP_LOGI(TAG, "Command \"AT%s\" received response, waiting for OK", cmd.command.c_str());
+      ESP_LOGI(TAG, "Command \"AT%s\" received response, waiting for OK", cmd.command->text);
       return false;
     }
 
     if (cmd.urc_required && !cmd.urc_received() && cmd.ok_received &&
-        is_response_or_urc(cmd.command, this->read_buffer_)) {
-      cmd.urc = std::move(this->read_buffer_);
+        cmd.command->matches(this->read_buffer_)) {
+      cmd.urc = this->read_buffer_;
       this->read_buffer_.clear();
-      cmd.is_pending = false;
-      this->state_ = cmd.success_state;
-      ESP_LOGI(TAG, "Command AT%s succeeded after %d ms", cmd.command.c_str(), cmd.runtime());
+      this->finish_command_(CommandResult::SUCCESS);
+      ESP_LOGI(TAG, "Command AT%s succeeded after %d ms", cmd.command->text, cmd.runtime());
       return true;
     }
 
+    if (this->dispatch_urc_(this->read_buffer_)) {
+      this->read_buffer_.clear();
+      return false;
+    }
+
     ESP_LOGV(TAG, "Ignoring: \"%s\"", this->read_buffer_.c_str());
     this->read_buffer_.clear();
     return false;
@@ -465,80 +1225,818 @@ bool Sim800LDataComponent::handle_response_() {
 
   if (cmd.is_pending) {
     if (cmd.timed_out()) {
-      cmd.is_pending = false;
-      this->state_ = cmd.error_state;
-      ESP_LOGE(TAG, "Command \"AT%s\" timed out after %d ms", cmd.command.c_str(), cmd.runtime());
+      this->finish_command_(CommandResult::TIMEOUT);
+      if (cmd.command->id == CommandId::AT_SYNC) {
+        // Expected while the module starts or autobauds
+        ESP_LOGD(TAG, "Command \"AT%s\" timed out after %d ms", cmd.command->text, cmd.runtime());
+      } else {
+        ESP_LOGE(TAG, "Command \"AT%s\" timed out after %d ms", cmd.command->text, cmd.runtime());
+      }
     }
     return false;
   }
   return true;
 }
 
-void Sim800LDataComponent::write_(const std::string &s) {
-  ESP_LOGV(TAG, "<-- %s", s.c_str());
-  this->write_str(s.c_str());
+void Sim800LDataComponent::finish_command_(CommandResult result) {
+  CommandState &cmd = this->command_state_;
+  cmd.is_pending = false;
+  this->state_ = result == CommandResult::SUCCESS ? cmd.success_state : cmd.error_state;
+
+  this->learn_timeout_(result);
+
+  const uint32_t runtime = cmd.runtime();
+  for (uint8_t i = 0; i < cmd.command_count; i++) {
+    this->command_stats_[static_cast<size_t>(cmd.commands[i]->id)].add(result, runtime);
+  }
+
+  // Buffers keep their capacity between commands, so this should stay 0 once warmed up
+  const uint8_t allocations = cmd.allocations();
+  if (allocations > 0) {
+    this->command_allocations_ += allocations;
+    ESP_LOGD(TAG, "Command \"AT%s\" grew %d buffers (%u in total)", cmd.command->text, allocations,
+             this->command_allocations_);
+  }
+}
+
+void Sim800LDataComponent::setup_flow_control_() {
+#ifdef USE_ESP32
+  if (!this->flow_control_enabled_()) {
+    return;
+  }
+  // Both ESP32 frameworks use the ESP-IDF UART driver, which handles RTS and CTS in hardware
+#ifdef USE_ESP_IDF
+  auto *uart = static_cast<uart::IDFUARTComponent *>(this->parent_);
+#else
+  auto *uart = static_cast<uart::ESP32ArduinoUARTComponent *>(this->parent_);
+#endif
+  const auto port = static_cast<uart_port_t>(uart->get_hw_serial_number());
+  if (uart_set_pin(port, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE, this->rts_pin_, this->cts_pin_) != ESP_OK ||
+      uart_set_hw_flow_ctrl(port, UART_HW_FLOWCTRL_CTS_RTS, FLOW_CONTROL_RX_THRESHOLD) != ESP_OK) {
+    ESP_LOGE(TAG, "Could not enable hardware flow control");
+    this->rts_pin_ = -1;
+    this->cts_pin_ = -1;
+  }
+#endif
+}
+
+void Sim800LDataComponent::set_uart_baud_rate_(uint32_t baud_rate) {
+  this->flush();
+  this->parent_->set_baud_rate(baud_rate);
+  this->parent_->load_settings(false);
+  // Reconfiguring the UART also resets its flow control
+  this->setup_flow_control_();
+  // Anything received during the switch is garbage
+  this->rx_buffer_.clear();
+  this->read_buffer_.clear();
 }
 
-void Sim800LDataComponent::write_line_(const std::string &s) {
-  ESP_LOGV(TAG, "<-- %s", s.c_str());
-  this->write_str(s.c_str());
+void Sim800LDataComponent::send_(const AtCommand &command, const char *argument) {
+  ESP_LOGV(TAG, "<-- AT%s%s%s", command.text, argument != nullptr ? argument : "",
+           command.suffix != nullptr ? command.suffix : "");
+  this->write_str(AT);
+  this->write_str(command.text);
+  if (argument != nullptr) {
+    this->write_str(argument);
+  }
+  if (command.suffix != nullptr) {
+    this->write_str(command.suffix);
+  }
   this->write_byte(CR);
   this->write_byte(LF);
 }
 
-void Sim800LDataComponent::await_ok_(const std::string &command, State success_state, State error_state,
-                                     uint32_t timeout) {
-  this->command_state_.reset(command, success_state, error_state, timeout);
-  this->write_(AT);
-  this->write_line_(command);
+void Sim800LDataComponent::await_(CommandId id, State success_state, State error_state, const char *argument) {
+  const AtCommand &command = at_command(id);
+  this->command_state_.reset(command, success_state, error_state);
+  this->apply_adaptive_timeout_();
+  this->send_(command, argument);
   this->command_state_.started();
 }
 
-void Sim800LDataComponent::await_response_(const std::string &command, State success_state, State error_state,
-                                           uint32_t timeout) {
-  this->command_state_.reset(command, success_state, error_state, timeout);
-  this->command_state_.response_required = true;
-  this->write_(AT);
-  this->write_line_(command);
-  this->command_state_.started();
+void Sim800LDataComponent::apply_adaptive_timeout_() {
+  CommandState &cmd = this->command_state_;
+  const LatencyEstimate *estimate = this->timeout_estimates_.find(cmd.command->id);
+  if (!this->adaptive_timeouts_ || estimate == nullptr) {
+    return;
+  }
+  // For URC and FINAL commands the whole runtime up to the last line is estimated, so it limits the URC timeout
+  const uint32_t timeout = estimate->timeout(cmd.command->max_runtime());
+  if (cmd.command->kind == ResponseKind::URC || cmd.command->kind == ResponseKind::FINAL) {
+    cmd.urc_timeout = timeout;
+  } else {
+    cmd.timeout = timeout;
+  }
+  cmd.adaptive = true;
 }
 
-void Sim800LDataComponent::await_urc_(const std::string &command, State success_state, State error_state,
-                                      uint32_t timeout, uint32_t urc_timeout) {
-  this->command_state_.reset(command, success_state, error_state, timeout);
-  this->command_state_.urc_timeout = urc_timeout;
-  this->command_state_.urc_required = true;
-  this->write_(AT);
-  this->write_line_(command);
-  this->command_state_.started();
+void Sim800LDataComponent::learn_timeout_(CommandResult result) {
+  const CommandState &cmd = this->command_state_;
+  // Errors are often returned immediately and say nothing about the latency
+  if (!cmd.adaptive || result == CommandResult::ERROR) {
+    return;
+  }
+  LatencyEstimate &estimate = *this->timeout_estimates_.find(cmd.command->id);
+  if (result == CommandResult::SUCCESS) {
+    estimate.add(cmd.runtime());
+  } else {
+    // Back off: a timeout counts as a sample of the timeout itself, which raises the next one
+    const bool urc = cmd.command->kind == ResponseKind::URC || cmd.command->kind == ResponseKind::FINAL;
+    estimate.add(urc ? cmd.urc_timeout : cmd.timeout);
+    ESP_LOGD(TAG, "Command \"AT%s\" timeout raised to %u ms", cmd.command->text,
+             estimate.timeout(cmd.command->max_runtime()));
+  }
+  this->timeout_estimates_changed_ = true;
 }
 
-void Sim800LDataComponent::await_data_(const std::string &command, uint32_t data_length, State success_state,
-                                       State error_state, uint32_t timeout) {
-  this->command_state_.reset(command, success_state, error_state, timeout);
-  this->command_state_.response_required = true;
+void Sim800LDataComponent::await_combined_(const CommandId *ids, uint8_t count, State success_state,
+                                           State error_state) {
+  CommandState &cmd = this->command_state_;
+  cmd.reset(at_command(ids[0]), success_state, error_state);
+  for (uint8_t i = 1; i < count; i++) {
+    cmd.add_command(at_command(ids[i]));
+  }
+
+  // e.g. AT+CBC;+CSQ;+CREG?
+  this->write_str(AT);
+  for (uint8_t i = 0; i < count; i++) {
+    if (i > 0) {
+      this->write_byte(';');
+    }
+    this->write_str(cmd.commands[i]->text);
+    ESP_LOGV(TAG, "<-- %s%s", i == 0 ? "AT" : ";", cmd.commands[i]->text);
+  }
+  this->write_byte(CR);
+  this->write_byte(LF);
+  cmd.started();
+}
+
+void Sim800LDataComponent::await_data_(CommandId id, const char *argument, uint32_t data_length,
+                                       State success_state, State error_state) {
+  const AtCommand &command = at_command(id);
+  this->command_state_.reset(command, success_state, error_state);
   this->command_state_.data_required = data_length;
-  this->write_(AT);
-  this->write_line_(command);
+  this->command_state_.data.reserve(data_length);
+  this->send_(command, argument);
   this->command_state_.started();
 }
 
-void Sim800LDataComponent::http_get(const std::string &url) {
-  if (this->http_state_.state == HttpState::PENDING) {
-    ESP_LOGE(TAG, "HTTP request pending, ignoring");
+void Sim800LDataComponent::await_input_ok_(CommandId id, State success_state, State error_state, uint32_t timeout) {
+  this->command_state_.reset(at_command(id), success_state, error_state);
+  this->command_state_.prompt_required = false;
+  this->command_state_.timeout = timeout;
+  this->command_state_.started();
+}
+
+void Sim800LDataComponent::handle_battery_response_(const std::string &response) {
+  // Example response: +CBC: 0,75,3980
+  uint8_t bcs, percent;
+  uint16_t voltage;
+  if (!parse_response(response, bcs, percent, voltage)) {
+    ESP_LOGW(TAG, "Invalid response: %s", response.c_str());
+    return;
+  }
+  ESP_LOGI(TAG, "Battery: %d%%, %dmV", percent, voltage);
+#ifdef USE_SENSOR
+  if (this->battery_level_sensor_ != nullptr) {
+    this->battery_level_sensor_->publish_state(percent);
+  }
+  if (this->battery_voltage_sensor_ != nullptr) {
+    this->battery_voltage_sensor_->publish_state(voltage / 1000.0f);
+  }
+#endif
+}
+
+bool Sim800LDataComponent::handle_registration_response_(const std::string &response) {
+  // Example response: +CREG: 1,1
+  // A +CREG: <stat> URC may arrive while +CREG? is pending and be taken as its response.
+  uint8_t n, stat;
+  if (!parse_response(response, n, stat) && !parse_response(response, stat)) {
+    ESP_LOGW(TAG, "Invalid response: %s", response.c_str());
+    stat = 0;
+  }
+  this->registered_ = stat == 1 || stat == 5;
+  if (!this->registered_) {
+    ESP_LOGE(TAG, "Not registered to network.");
+    return false;
+  }
+  return true;
+}
+
+void Sim800LDataComponent::subscribe_urc(const char *prefix, std::function<void(const std::string &)> callback) {
+  this->urc_subscriptions_.push_back({prefix, strlen(prefix), std::move(callback)});
+}
+
+bool Sim800LDataComponent::dispatch_urc_(const std::string &line) {
+  bool handled = false;
+  for (const auto &subscription : this->urc_subscriptions_) {
+    if (line.compare(0, subscription.prefix_length, subscription.prefix) == 0) {
+      subscription.callback(line);
+      handled = true;
+    }
+  }
+  return handled;
+}
+
+void Sim800LDataComponent::on_registration_urc_(const std::string &line) {
+  // Example URC: +CREG: 1
+  uint8_t stat;
+  if (!parse_response(line, stat)) {
+    ESP_LOGW(TAG, "Invalid URC: %s", line.c_str());
+    return;
+  }
+  const bool registered = stat == 1 || stat == 5;
+  if (registered != this->registered_) {
+    ESP_LOGI(TAG, "Registration changed: %s", registered ? "registered" : "not registered");
+    if (registered) {
+      // Coverage is back, don't wait for the retry interval of the outbox
+      this->outbox_next_flush_ = millis();
+    }
+  }
+  this->registered_ = registered;
+}
+
+void Sim800LDataComponent::on_bearer_deact_urc_(const std::string &line) {
+  // The network closed the bearer. The next request will open it again.
+  ESP_LOGW(TAG, "Bearer was deactivated by the network");
+  this->bearer_open_ = false;
+}
+
+void Sim800LDataComponent::on_socket_lost_urc_(const std::string &line) {
+  // Close the socket and the GPRS context from IDLE
+  if (this->socket_status_ == SocketStatus::CONNECTED) {
+    ESP_LOGW(TAG, "Socket lost: %s", line.c_str());
+    this->socket_status_ = SocketStatus::CLOSE_REQUESTED;
+  }
+}
+
+void Sim800LDataComponent::on_sim_ready_urc_(const std::string &line) {
+  ESP_LOGD(TAG, "%s", line.c_str());
+  this->sim_ready_ = true;
+}
+
+void Sim800LDataComponent::on_ready_urc_(const std::string &line) {
+  // The module has (re)started and lost all settings, so run the full initialization.
+  if (this->initialized_) {
+    ESP_LOGW(TAG, "Module restarted, initializing again");
+  }
+  this->command_state_.is_pending = false;
+  this->wait_.start(0);
+  this->sim_ready_ = false;
+  this->idle_sleep_active_ = false;
+  this->dtr_sleep_enabled_ = false;
+  if (this->dtr_pin_ != nullptr) {
+    this->dtr_pin_->digital_write(false);
+  }
+  this->bearer_open_ = false;
+  if (this->socket_status_ == SocketStatus::CONNECTED || this->socket_status_ == SocketStatus::CONNECTING) {
+    this->socket_status_ = SocketStatus::CLOSED;
+    this->socket_rx_pending_ = false;
+    this->socket_tx_queue_.clear();
+    if (this->socket_keep_alive_) {
+      this->keep_alive_closed_(true);
+    } else {
+      this->socket_closed_callback_.call();
+    }
+  }
+  this->state_ = State::INIT;
+}
+
+void Sim800LDataComponent::handle_signal_quality_response_(const std::string &response) {
+  // Example response: +CSQ: 17,0
+  uint8_t rssi;
+  if (!parse_response(response, rssi)) {
+    ESP_LOGW(TAG, "Invalid response: %s", response.c_str());
     return;
   }
-  if (this->http_state_.state == HttpState::QUEUED) {
-    ESP_LOGW(TAG, "HTTP request queued, overwriting");
+  const int8_t dbm = get_rssi_dbm(rssi);
+  ESP_LOGI(TAG, "RSSI: %d dBm", dbm);
+#ifdef USE_SENSOR
+  if (this->signal_strength_sensor_ != nullptr) {
+    this->signal_strength_sensor_->publish_state(dbm);
+  }
+#endif
+}
+
+void Sim800LDataComponent::log_http_stats_(const HttpRequest &request) {
+  const uint32_t now = millis();
+  const uint32_t rx_bytes = this->rx_bytes_ - request.start.rx_bytes;
+  const uint32_t rx_time_us = this->rx_time_us_ - request.start.rx_time_us;
+  char buffer[512];
+  int length = snprintf(buffer, sizeof(buffer),
+                        "{\"status\":%u,\"total_ms\":%u,\"queue_ms\":%u,\"transitions\":%u,\"rx_bytes\":%u,"
+                        "\"rx_us\":%u,\"rx_ns_per_byte\":%u,\"allocations\":%u,\"state_ms\":{",
+                        request.status_code, now - request.start.queued_at,
+                        request.start.started_at - request.start.queued_at,
+                        this->state_transitions_ - request.start.transitions, rx_bytes, rx_time_us,
+                        rx_bytes > 0 ? static_cast<uint32_t>(uint64_t(rx_time_us) * 1000 / rx_bytes) : 0,
+                        this->command_allocations_ - request.start.allocations);
+  bool first = true;
+  for (size_t i = 0; i < STATE_COUNT && length > 0 && length < static_cast<int>(sizeof(buffer)); i++) {
+    if (this->state_time_[i] == 0) {
+      continue;
+    }
+    length += snprintf(buffer + length, sizeof(buffer) - length, "%s\"%s\":%u", first ? "" : ",",
+                       state_to_string(static_cast<State>(i)), this->state_time_[i]);
+    first = false;
+  }
+  if (length > 0 && length < static_cast<int>(sizeof(buffer))) {
+    snprintf(buffer + length, sizeof(buffer) - length, "}}");
   }
-  this->http_state_.reset();
-  this->http_state_.state = HttpState::QUEUED;
-  this->http_state_.method = HttpState::GET;
-  this->http_state_.url = url;
-  this->http_state_.ssl =
+  ESP_LOGI(TAG, "HTTP stats: %s", buffer);
+}
+
+HttpRequest *Sim800LDataComponent::queue_http_request_(const std::string &url) {
+  if (this->http_queue_.full()) {
+    this->http_dropped_count_++;
+    ESP_LOGE(TAG, "HTTP queue full, dropping request (%u dropped)", this->http_dropped_count_);
+    return nullptr;
+  }
+  HttpRequest &request = this->http_queue_.push();
+  request.url = url;
+  request.endpoint_hash = fnv1_hash(std::string(url_endpoint(url)));
+  request.start.queued_at = millis();
+  request.ssl =
       url.size() >= strlen(HTTPS_PROTO) && strcasecmp(url.substr(0, strlen(HTTPS_PROTO)).c_str(), HTTPS_PROTO) == 0;
+  return &request;
+}
+
+void Sim800LDataComponent::socket_connect(SocketProtocol protocol, const std::string &host, uint16_t port) {
+  if (this->socket_status_ != SocketStatus::CLOSED) {
+    ESP_LOGW(TAG, "Socket is already open, close it first");
+    return;
+  }
+  this->socket_protocol_ = protocol;
+  this->socket_host_ = host;
+  this->socket_port_ = port;
+  this->socket_status_ = SocketStatus::CONNECT_REQUESTED;
+  ESP_LOGI(TAG, "Socket connect queued: %s %s:%u", protocol == SocketProtocol::UDP ? "UDP" : "TCP", host.c_str(),
+           port);
+}
+
+bool Sim800LDataComponent::socket_send(std::string data) {
+  if (this->socket_keep_alive_) {
+    ESP_LOGW(TAG, "Socket is used for HTTP keep-alive, dropping %u bytes", (unsigned) data.size());
+    return false;
+  }
+  return this->socket_send_(std::move(data));
+}
+
+bool Sim800LDataComponent::socket_close() {
+  if (this->socket_keep_alive_) {
+    ESP_LOGW(TAG, "Socket is used for HTTP keep-alive, not closing it");
+    return false;
+  }
+  this->socket_close_();
+  return true;
+}
+
+bool Sim800LDataComponent::socket_send_(std::string data) {
+  if (this->socket_status_ != SocketStatus::CONNECTED && this->socket_status_ != SocketStatus::CONNECTING &&
+      this->socket_status_ != SocketStatus::CONNECT_REQUESTED) {
+    ESP_LOGW(TAG, "Socket is not open, dropping %u bytes", (unsigned) data.size());
+    return false;
+  }
+  if (data.empty() || data.size() > SOCKET_MAX_SEND_SIZE) {
+    ESP_LOGW(TAG, "Socket data must be 1 to %u bytes, dropping %u bytes", SOCKET_MAX_SEND_SIZE,
+             (unsigned) data.size());
+    return false;
+  }
+  if (this->socket_tx_queue_.size() >= SOCKET_TX_QUEUE_SIZE) {
+    ESP_LOGW(TAG, "Socket send queue full, dropping %u bytes", (unsigned) data.size());
+    return false;
+  }
+  this->socket_tx_queue_.push_back(std::move(data));
+  return true;
+}
+
+void Sim800LDataComponent::socket_close_() {
+  if (this->socket_status_ == SocketStatus::CONNECT_REQUESTED) {
+    this->socket_status_ = SocketStatus::CLOSED;
+    this->socket_tx_queue_.clear();
+  } else if (this->socket_status_ == SocketStatus::CONNECTED) {
+    this->socket_status_ = SocketStatus::CLOSE_REQUESTED;
+  }
+}
+
+void Sim800LDataComponent::deliver_http_response_(uint16_t status_code, std::string &body) {
+  this->http_binary_response_callback_.call(status_code, reinterpret_cast<const uint8_t *>(body.data()), body.size());
+  // Replace \0 with space because it would terminate the string,
+  // but keep the data length same.
+  std::replace(body.begin(), body.end(), '\0', ' ');
+  this->http_request_done_callback_.call(status_code, body);
+  for (auto &callback : this->http_queue_.front().callbacks) {
+    callback(status_code, body);
+  }
+}
+
+void Sim800LDataComponent::http_request_failed_(size_t index) {
+  std::string body;
+  for (auto &callback : this->http_queue_.at(index).callbacks) {
+    callback(0, body);
+  }
+  this->http_request_failed_callback_.call();
+}
+
+HttpRequest *Sim800LDataComponent::find_queued_get_(const std::string &url) {
+  const std::string_view endpoint = url_endpoint(url);
+  const uint32_t hash = fnv1_hash(std::string(endpoint));
+  for (size_t i = this->http_queue_.size(); i > 0; i--) {
+    HttpRequest &request = this->http_queue_.at(i - 1);
+    if (request.state == HttpRequest::QUEUED && request.method == HttpRequest::GET && request.endpoint_hash == hash &&
+        url_endpoint(request.url) == endpoint) {
+      return &request;
+    }
+  }
+  return nullptr;
+}
+
+bool Sim800LDataComponent::http_request_ready_(const HttpRequest &request, uint32_t now) const {
+  if (this->http_min_interval_ == 0 || request.method != HttpRequest::GET) {
+    return true;
+  }
+  for (const EndpointTime &endpoint : this->endpoint_times_) {
+    if (endpoint.hash == request.endpoint_hash) {
+      return now - endpoint.started_at >= this->http_min_interval_;
+    }
+  }
+  return true;
+}
+
+void Sim800LDataComponent::record_endpoint_time_(const HttpRequest &request) {
+  const uint32_t now = millis();
+  EndpointTime *oldest = nullptr;
+  for (EndpointTime &endpoint : this->endpoint_times_) {
+    if (endpoint.hash == request.endpoint_hash) {
+      endpoint.started_at = now;
+      return;
+    }
+    if (oldest == nullptr || now - endpoint.started_at > now - oldest->started_at) {
+      oldest = &endpoint;
+    }
+  }
+  if (this->endpoint_times_.size() < MAX_TRACKED_ENDPOINTS) {
+    this->endpoint_times_.push_back({request.endpoint_hash, now});
+  } else {
+    *oldest = {request.endpoint_hash, now};
+  }
+}
+
+void Sim800LDataComponent::deliver_http_chunk_(uint32_t offset, std::string &chunk) {
+  this->http_binary_chunk_callback_.call(offset, reinterpret_cast<const uint8_t *>(chunk.data()), chunk.size());
+  std::replace(chunk.begin(), chunk.end(), '\0', ' ');
+  this->http_response_chunk_callback_.call(offset, chunk);
+}
+
+void Sim800LDataComponent::deliver_socket_data_(std::string &data) {
+  this->socket_binary_data_callback_.call(reinterpret_cast<const uint8_t *>(data.data()), data.size());
+  std::replace(data.begin(), data.end(), '\0', ' ');
+  this->socket_data_callback_.call(data);
+}
+
+bool Sim800LDataComponent::outbox_add(const std::string &payload) {
+  if (this->outbox_.capacity() == 0) {
+    ESP_LOGE(TAG, "No outbox configured");
+    return false;
+  }
+  if (payload.size() > OUTBOX_ENTRY_SIZE) {
+    ESP_LOGE(TAG, "Outbox payload too long (%u bytes, max %u)", (unsigned) payload.size(), OUTBOX_ENTRY_SIZE);
+    return false;
+  }
+  const bool full = this->outbox_.size() == this->outbox_.capacity();
+  if (!this->outbox_.push(payload)) {
+    ESP_LOGE(TAG, "Outbox entry could not be saved");
+    return false;
+  }
+  if (full) {
+    ESP_LOGW(TAG, "Outbox full, dropped oldest entry (%u dropped)", this->outbox_.get_dropped());
+  }
+  ESP_LOGD(TAG, "Outbox entry stored, %u entries", (unsigned) this->outbox_.size());
+  return true;
+}
+
+bool Sim800LDataComponent::outbox_flush_due_(uint32_t now) const {
+  return !this->outbox_.empty() && !this->outbox_flushing_ && static_cast<int32_t>(now - this->outbox_next_flush_) >= 0;
+}
+
+void Sim800LDataComponent::flush_outbox_() {
+  // Entries added while the request is pending stay in the outbox for the next flush.
+  // Only the sequence numbers and lengths are kept, the body is read from flash while it is sent.
+  std::vector<OutboxPart> parts;
+  const size_t count = this->outbox_.size();
+  parts.reserve(count);
+  uint32_t body_size = 0;
+  OutboxEntry entry;
+  for (size_t i = 0; i < count; i++) {
+    if (!this->outbox_.load(i, entry)) {
+      // Corrupted entries are removed with the others when the request succeeds
+      ESP_LOGW(TAG, "Outbox entry %u could not be read", (unsigned) i);
+      continue;
+    }
+    body_size += (parts.empty() ? 0 : 1) + entry.length;
+    parts.push_back({entry.sequence, entry.length});
+  }
+  const uint32_t sequence = this->outbox_.sequence(count - 1);
+  if (body_size == 0) {
+    this->outbox_.remove_through(sequence);
+    return;
+  }
+  HttpRequest *request = this->queue_http_request_(this->outbox_url_);
+  if (request == nullptr) {
+    return;
+  }
+  ESP_LOGI(TAG, "Sending %u outbox entries (%u bytes)", (unsigned) parts.size(), (unsigned) body_size);
+  this->outbox_flushing_ = true;
+  request->method = HttpRequest::POST;
+  request->content_type = this->outbox_content_type_;
+  request->outbox_sequence = sequence;
+  request->body_size = body_size;
+  request->body_provider = [this, parts = std::move(parts)](uint32_t offset, uint8_t *buffer, size_t length) {
+    return this->outbox_.read_body(parts, offset, buffer, length);
+  };
+}
+
+void Sim800LDataComponent::outbox_flushed_(const HttpRequest &request) {
+  this->outbox_flushing_ = false;
+  if (request.status_code >= 200 && request.status_code <= 299) {
+    this->outbox_.remove_through(request.outbox_sequence);
+    ESP_LOGI(TAG, "Outbox sent, %u entries left", (unsigned) this->outbox_.size());
+    this->outbox_next_flush_ = millis();
+  } else {
+    ESP_LOGW(TAG, "Outbox could not be sent (status %u), retrying in %u s", request.status_code,
+             OUTBOX_RETRY_INTERVAL / 1000);
+    this->outbox_next_flush_ = millis() + OUTBOX_RETRY_INTERVAL;
+  }
+}
+
+void Sim800LDataComponent::start_http_request_(HttpRequest &request) {
+  request.state = HttpRequest::PENDING;
+  if (this->http_min_interval_ > 0 && request.method == HttpRequest::GET) {
+    this->record_endpoint_time_(request);
+  }
+  request.start.started_at = millis();
+  request.start.transitions = this->state_transitions_;
+  request.start.rx_bytes = this->rx_bytes_;
+  request.start.rx_time_us = this->rx_time_us_;
+  request.start.allocations = this->command_allocations_;
+}
+
+void Sim800LDataComponent::finish_http_request_(size_t index) {
+  const HttpRequest &request = this->http_queue_.at(index);
+  if (request.outbox_sequence > 0) {
+    this->outbox_flushed_(request);
+  }
+  ESP_LOGD(TAG, "HTTP request finished after %u ms (%u ms in queue, %u state transitions)",
+           millis() - request.start.queued_at, request.start.started_at - request.start.queued_at,
+           this->state_transitions_ - request.start.transitions);
+  if (this->http_stats_) {
+    this->log_http_stats_(request);
+  }
+  memset(this->state_time_, 0, sizeof(this->state_time_));
+  this->http_queue_.remove(index);
+}
+
+IdleJob Sim800LDataComponent::next_idle_job_(uint32_t now) {
+  CommandId checks[MAX_COMBINED_COMMANDS];
+  if (!this->registered_) {
+    return IdleJob::REGISTRATION_LOST;
+  }
+  // Checks are deferred while there is traffic, but not past their deadline
+  if (this->due_checks_(now, CHECK_DEADLINE_INTERVALS, checks) > 0) {
+    return IdleJob::OVERDUE_CHECKS;
+  }
+  if (this->socket_work_pending_()) {
+    return IdleJob::SOCKET;
+  }
+  if (this->keep_alive_work_pending_()) {
+    return IdleJob::KEEP_ALIVE;
+  }
+  if (this->http_request_startable_(now)) {
+    return IdleJob::HTTP_REQUEST;
+  }
+  if (this->due_checks_(now, 1, checks) > 0) {
+    return IdleJob::CHECKS;
+  }
+  if (this->bearer_open_ && now - this->bearer_idle_since_ >= this->keep_bearer_open_ &&
+      !this->http_request_deferred_(now)) {
+    return IdleJob::BEARER_CLOSE;
+  }
+  if (this->http_queue_.empty() && this->outbox_flush_due_(now)) {
+    return IdleJob::OUTBOX;
+  }
+  const uint32_t keep_alive_timeout = this->keep_alive_sent_ > 0 ? DEFAULT_URC_TIMEOUT : this->keep_bearer_open_;
+  if (this->socket_keep_alive_ && this->socket_status_ == SocketStatus::CONNECTED &&
+      now - this->keep_alive_activity_ >= keep_alive_timeout) {
+    return IdleJob::KEEP_ALIVE_CLOSE;
+  }
+  if (this->idle_sleep_ && !this->idle_sleep_active_) {
+    return IdleJob::SLEEP;
+  }
+  return IdleJob::NONE;
+}
+
+uint8_t Sim800LDataComponent::due_checks_(uint32_t now, uint32_t intervals, CommandId *checks) const {
+  // Divide the elapsed time instead of multiplying the interval, which could overflow
+  uint8_t count = 0;
+  if ((now - this->last_battery_check_) / intervals >= this->battery_check_interval_) {
+    checks[count++] = CommandId::CHECK_BATTERY;
+  }
+  if ((now - this->last_signal_check_) / intervals >= this->signal_check_interval_) {
+    checks[count++] = CommandId::CHECK_SIGNAL_QUALITY;
+  }
+  if (this->registration_check_interval_ > 0 &&
+      (now - this->last_registration_check_) / intervals >= this->registration_check_interval_) {
+    checks[count++] = CommandId::CHECK_REGISTRATION;
+  }
+  return count;
+}
+
+bool Sim800LDataComponent::http_request_startable_(uint32_t now) {
+  if (this->keep_alive_sent_ > 0) {
+    return false;
+  }
+  for (size_t i = 0; i < this->http_queue_.size(); i++) {
+    const HttpRequest &request = this->http_queue_.at(i);
+    if (!this->http_request_ready_(request, now)) {
+      continue;
+    }
+    if (this->use_keep_alive_(request)) {
+      return false;
+    }
+    this->http_queue_.move_to(i, 0);
+    return true;
+  }
+  return false;
+}
+
+bool Sim800LDataComponent::http_request_deferred_(uint32_t now) {
+  for (size_t i = this->keep_alive_sent_; i < this->http_queue_.size(); i++) {
+    const HttpRequest &request = this->http_queue_.at(i);
+    if (!this->use_keep_alive_(request) && !this->http_request_ready_(request, now)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool Sim800LDataComponent::use_keep_alive_(const HttpRequest &request) const {
+  std::string_view host, path;
+  uint16_t port;
+  return this->http_keep_alive_ && request.method == HttpRequest::GET && !request.ssl &&
+         (this->socket_status_ == SocketStatus::CLOSED || this->socket_keep_alive_) &&
+         parse_http_url(request.url, host, port, path);
+}
+
+bool Sim800LDataComponent::keep_alive_work_pending_() {
+  const uint32_t now = millis();
+  size_t index = this->keep_alive_sent_;
+  while (index < this->http_queue_.size() && !this->http_request_ready_(this->http_queue_.at(index), now)) {
+    index++;
+  }
+  if (index == this->http_queue_.size() || !this->use_keep_alive_(this->http_queue_.at(index))) {
+    return false;
+  }
+  this->http_queue_.move_to(index, this->keep_alive_sent_);
+  const HttpRequest &next = this->http_queue_.at(this->keep_alive_sent_);
+  if (this->socket_status_ == SocketStatus::CLOSED) {
+    return true;
+  }
+  if (this->socket_status_ != SocketStatus::CONNECTED) {
+    return false;
+  }
+  // Requests for another host have to wait until all responses of this one have arrived
+  std::string_view host, path;
+  uint16_t port;
+  parse_http_url(next.url, host, port, path);
+  return this->keep_alive_sent_ == 0 || (host == this->socket_host_ && port == this->socket_port_);
+}
+
+void Sim800LDataComponent::handle_keep_alive_data_(const std::string &data) {
+  this->keep_alive_activity_ = millis();
+  size_t pos = 0;
+  while (pos < data.size()) {
+    pos += this->keep_alive_parser_.feed(data.data() + pos, data.size() - pos);
+    if (!this->keep_alive_parser_.complete()) {
+      break;
+    }
+    this->complete_keep_alive_response_();
+  }
+}
+
+void Sim800LDataComponent::complete_keep_alive_response_() {
+  HttpResponseParser &parser = this->keep_alive_parser_;
+  if (this->keep_alive_sent_ == 0) {
+    ESP_LOGW(TAG, "Unexpected HTTP response %u", parser.status_code());
+    parser.reset();
+    return;
+  }
+  HttpRequest &request = this->http_queue_.front();
+  request.status_code = parser.status_code();
+  ESP_LOGI(TAG, "HTTP response %u with %u bytes", request.status_code, (unsigned) parser.body().size());
+  this->deliver_http_response_(request.status_code, parser.body());
+  if (!parser.keep_alive() && this->socket_status_ == SocketStatus::CONNECTED) {
+    // Requests written after this one are written again on a new connection
+    ESP_LOGD(TAG, "Server closes the connection");
+    this->socket_close_();
+  }
+  parser.reset();
+  this->keep_alive_sent_--;
+  this->finish_http_request_();
+}
+
+void Sim800LDataComponent::keep_alive_closed_(bool connected) {
+  if (this->keep_alive_parser_.finish_on_close()) {
+    this->complete_keep_alive_response_();
+  }
+  if (!connected && !this->http_queue_.empty()) {
+    ESP_LOGE(TAG, "HTTP connection failed: %s", this->http_queue_.front().url.c_str());
+    this->http_request_failed_();
+    this->finish_http_request_();
+  }
+  // Requests without a response are written again on a new connection, but only once
+  size_t unanswered = this->keep_alive_sent_;
+  this->keep_alive_sent_ = 0;
+  if (unanswered > 0 && this->http_queue_.front().retried) {
+    ESP_LOGE(TAG, "HTTP connection closed without response: %s", this->http_queue_.front().url.c_str());
+    this->http_request_failed_();
+    this->finish_http_request_();
+    unanswered--;
+  }
+  for (size_t i = 0; i < unanswered; i++) {
+    this->http_queue_.at(i).state = HttpRequest::QUEUED;
+    this->http_queue_.at(i).retried = true;
+  }
+  this->socket_keep_alive_ = false;
+  this->keep_alive_parser_.reset();
+}
+
+bool Sim800LDataComponent::socket_work_pending_() const {
+  switch (this->socket_status_) {
+    case SocketStatus::CONNECT_REQUESTED:
+    case SocketStatus::CLOSE_REQUESTED:
+      return true;
+    case SocketStatus::CONNECTED:
+      return this->socket_rx_pending_ || !this->socket_tx_queue_.empty();
+    default:
+      return false;
+  }
+}
+
+void Sim800LDataComponent::http_get(const std::string &url, HttpResultCallback callback) {
+  HttpRequest *queued = this->http_coalesce_ == HttpCoalesce::NONE ? nullptr : this->find_queued_get_(url);
+  if (queued != nullptr) {
+    if (this->http_coalesce_ == HttpCoalesce::MERGE_QUERY) {
+      queued->url = merge_url_query(queued->url, url);
+    } else {
+      queued->url = url;
+    }
+    if (callback) {
+      queued->callbacks.push_back(std::move(callback));
+    }
+    this->http_coalesced_count_++;
+    ESP_LOGI(TAG, "HTTP GET coalesced: %s", queued->url.c_str());
+    return;
+  }
+
+  HttpRequest *request = this->queue_http_request_(url);
+  if (request == nullptr) {
+    if (callback) {
+      std::string body;
+      callback(0, body);
+    }
+    return;
+  }
+  request->method = HttpRequest::GET;
+  if (callback) {
+    request->callbacks.push_back(std::move(callback));
+  }
+
+  ESP_LOGI(TAG, "HTTP GET queued: %s ssl=%d, queue depth %u", url.c_str(), request->ssl,
+           (unsigned) this->http_queue_.size());
+}
+
+void Sim800LDataComponent::http_post(const std::string &url, const std::string &content_type, uint32_t body_size,
+                                     HttpBodyProvider body_provider) {
+  HttpRequest *request = this->queue_http_request_(url);
+  if (request == nullptr) {
+    return;
+  }
+  request->method = HttpRequest::POST;
+  request->content_type = content_type;
+  request->body_size = body_size;
+  request->body_provider = std::move(body_provider);
+
+  ESP_LOGI(TAG, "HTTP POST queued: %s ssl=%d, %u bytes, queue depth %u", url.c_str(), request->ssl, body_size,
+           (unsigned) this->http_queue_.size());
+}
 
-  ESP_LOGI(TAG, "HTTP GET queued: %s ssl=%d", url.c_str(), this->http_state_.ssl);
+void Sim800LDataComponent::http_post(const std::string &url, const std::string &content_type, std::string body) {
+  const uint32_t body_size = body.size();
+  this->http_post(url, content_type, body_size,
+                  [body = std::move(body)](uint32_t offset, uint8_t *buffer, size_t length) -> size_t {
+                    memcpy(buffer, body.data() + offset, length);
+                    return length;
+                  });
 }
 
 }  // namespace sim800l_data
@@ -1,10 +1,22 @@
 #pragma once
 
+#include <algorithm>
+#include <deque>
+
 #include "esphome/core/helpers.h"
 #include "esphome/core/defines.h"
 #include "esphome/core/component.h"
 #include "esphome/core/log.h"
+#include "esphome/core/preferences.h"
 #include "esphome/components/uart/uart.h"
+#ifdef USE_ESP32
+#include <driver/uart.h>
+#ifdef USE_ESP_IDF
+#include "esphome/components/uart/uart_component_esp_idf.h"
+#else
+#include "esphome/components/uart/uart_component_esp32_arduino.h"
+#endif
+#endif
 #include "esphome/core/automation.h"
 #ifdef USE_SENSOR
 #include "esphome/components/sensor/sensor.h"
@@ -13,6 +25,9 @@
 #include "constants.h"
 #include "states.h"
 #include "helpers.h"
+#include "rx_buffer.h"
+#include "http_parser.h"
+#include "outbox.h"
 
 namespace esphome {
 namespace sim800l_data {
@@ -28,10 +43,105 @@ class Sim800LDataComponent : public uart::UARTDevice, public PollingComponent {
   void set_apn_user(std::string apn_user) { this->apn_user_ = std::move(apn_user); }
   void set_apn_password(std::string apn_password) { this->apn_password_ = std::move(apn_password); }
   void set_idle_sleep(bool idle_sleep) { this->idle_sleep_ = idle_sleep; }
-  void http_get(const std::string &url);
+  // Put the module to sleep and wake it with this pin connected to DTR, instead of with AT commands.
+  void set_dtr_pin(GPIOPin *dtr_pin) { this->dtr_pin_ = dtr_pin; }
+  // Enable RTS/CTS hardware flow control on these GPIOs (ESP32 only).
+  void set_flow_control_pins(int8_t rts_pin, int8_t cts_pin) {
+    this->rts_pin_ = rts_pin;
+    this->cts_pin_ = cts_pin;
+  }
+  // Switch the module and the UART to this baud rate during initialization. 0 keeps the UART baud rate.
+  void set_target_baud_rate(uint32_t target_baud_rate) { this->target_baud_rate_ = target_baud_rate; }
+  void set_battery_check_interval(uint32_t interval) { this->battery_check_interval_ = interval; }
+  void set_registration_check_interval(uint32_t interval) { this->registration_check_interval_ = interval; }
+  void set_signal_check_interval(uint32_t interval) { this->signal_check_interval_ = interval; }
+  void set_http_queue_size(uint8_t http_queue_size) { this->http_queue_.set_capacity(http_queue_size); }
+  // Keep the bearer and HTTP session open for this long after the last request. 0 closes it immediately.
+  void set_keep_bearer_open(uint32_t keep_bearer_open) { this->keep_bearer_open_ = keep_bearer_open; }
+  // Send plain http:// GET requests over one kept-alive TCP connection, several at once.
+  void set_http_keep_alive(bool http_keep_alive) { this->http_keep_alive_ = http_keep_alive; }
+  // Log a machine-readable summary of each HTTP request.
+  void set_http_stats(bool http_stats) { this->http_stats_ = http_stats; }
+  // Stream response bodies in chunks of the given size to the chunk callbacks
+  // instead of collecting them in memory.
+  void set_stream_response(bool stream_response) { this->stream_response_ = stream_response; }
+  void set_response_chunk_size(uint16_t response_chunk_size) { this->response_chunk_size_ = response_chunk_size; }
+  // Derive command timeouts from their observed latency instead of using the fixed maximum.
+  void set_adaptive_timeouts(bool adaptive_timeouts) { this->adaptive_timeouts_ = adaptive_timeouts; }
+  // Keep the latency estimates of adaptive timeouts across reboots.
+  void set_persist_timeouts(bool persist_timeouts) { this->persist_timeouts_ = persist_timeouts; }
+  // Keep payloads added with outbox_add() in a ring of size entries in flash, and send all of them
+  // in one POST to url, one per line, whenever the network is available.
+  void set_outbox(const std::string &url, const std::string &content_type, uint8_t size) {
+    this->outbox_url_ = url;
+    this->outbox_content_type_ = content_type;
+    this->outbox_size_ = size;
+  }
+  // Store a payload in the outbox. Returns false if there is no outbox, the payload is too long or it could
+  // not be saved.
+  bool outbox_add(const std::string &payload);
+  // Number of payloads in the outbox that were not sent yet.
+  size_t get_outbox_depth() const { return this->outbox_.size(); }
+  // Combine http_get() calls with a queued request to the same endpoint.
+  void set_http_coalesce(HttpCoalesce http_coalesce) { this->http_coalesce_ = http_coalesce; }
+  // Minimum time between the start of two GET requests to the same endpoint. Later requests wait in the queue.
+  void set_http_min_interval(uint32_t http_min_interval) { this->http_min_interval_ = http_min_interval; }
+  // Queue a HTTP GET request. If it is coalesced with a queued request, callback is called with the result
+  // of that request, together with the callbacks of the other calls.
+  void http_get(const std::string &url, HttpResultCallback callback = nullptr);
+  // Queue a HTTP POST request. The body is requested from body_provider in chunks
+  // while it is written to the module, so it never has to be held in memory at once.
+  void http_post(const std::string &url, const std::string &content_type, uint32_t body_size,
+                 HttpBodyProvider body_provider);
+  void http_post(const std::string &url, const std::string &content_type, std::string body);
+  // Number of HTTP requests that are queued or pending.
+  size_t get_http_queue_depth() const { return this->http_queue_.size(); }
+  // Number of times the state machine changed its state.
+  uint32_t get_state_transitions() const { return this->state_transitions_; }
+  // Number of times the UART driver buffer was found full, so received bytes may have been lost.
+  uint32_t get_rx_overruns() const { return this->rx_overruns_; }
+  // Number of times received data was purged because no line end was found.
+  uint32_t get_rx_purges() const { return this->rx_purges_; }
+  // Number of http_get() calls that were coalesced with a queued request.
+  uint32_t get_http_coalesced_count() const { return this->http_coalesced_count_; }
+  // Number of HTTP requests that were dropped because the queue was full.
+  uint32_t get_http_dropped_count() const { return this->http_dropped_count_; }
+  // Call callback for every unsolicited line starting with prefix, whether a command is pending or not.
+  void subscribe_urc(const char *prefix, std::function<void(const std::string &)> callback);
+  // Open a TCP or UDP connection with the IP stack of the module (AT+CIPSTART). Only one socket can be open.
+  void socket_connect(SocketProtocol protocol, const std::string &host, uint16_t port);
+  // Queue data to be sent with one AT+CIPSEND. Returns false if it was dropped.
+  bool socket_send(std::string data);
+  // Returns false if the socket is used for HTTP keep-alive, which closes it by itself.
+  bool socket_close();
+  bool is_socket_connected() const { return this->socket_status_ == SocketStatus::CONNECTED; }
+  void add_on_socket_connected_callback(std::function<void()> callback) {
+    this->socket_connected_callback_.add(std::move(callback));
+  }
+  void add_on_socket_data_callback(std::function<void(std::string &)> callback) {
+    this->socket_data_callback_.add(std::move(callback));
+  }
+  // Called when the socket was closed, was lost or could not be opened.
+  void add_on_socket_closed_callback(std::function<void()> callback) {
+    this->socket_closed_callback_.add(std::move(callback));
+  }
   void add_on_http_request_done_callback(std::function<void(uint16_t, std::string &)> callback) {
     this->http_request_done_callback_.add(std::move(callback));
   }
+  void add_on_http_response_chunk_callback(std::function<void(uint32_t, std::string &)> callback) {
+    this->http_response_chunk_callback_.add(std::move(callback));
+  }
+  // Binary-safe variants of the callbacks above. The data is passed unchanged, including \0 bytes,
+  // and only valid during the call. The string callbacks get \0 replaced with space.
+  void add_on_http_binary_response_callback(std::function<void(uint16_t, const uint8_t *, size_t)> callback) {
+    this->http_binary_response_callback_.add(std::move(callback));
+  }
+  void add_on_http_binary_chunk_callback(std::function<void(uint32_t, const uint8_t *, size_t)> callback) {
+    this->http_binary_chunk_callback_.add(std::move(callback));
+  }
+  void add_on_socket_binary_data_callback(std::function<void(const uint8_t *, size_t)> callback) {
+    this->socket_binary_data_callback_.add(std::move(callback));
+  }
   void add_on_http_request_failed_callback(std::function<void(void)> callback) {
     this->http_request_failed_callback_.add(std::move(callback));
   }
@@ -39,103 +149,357 @@ class Sim800LDataComponent : public uart::UARTDevice, public PollingComponent {
   void set_signal_strength_sensor(sensor::Sensor *sensor) { signal_strength_sensor_ = sensor; }
   void set_battery_level_sensor(sensor::Sensor *sensor) { battery_level_sensor_ = sensor; }
   void set_battery_voltage_sensor(sensor::Sensor *sensor) { battery_voltage_sensor_ = sensor; }
+  void set_command_errors_sensor(sensor::Sensor *sensor) { command_errors_sensor_ = sensor; }
+  void set_command_timeouts_sensor(sensor::Sensor *sensor) { command_timeouts_sensor_ = sensor; }
+  void set_bearer_open_time_sensor(sensor::Sensor *sensor) { bearer_open_time_sensor_ = sensor; }
+  void set_http_action_time_sensor(sensor::Sensor *sensor) { http_action_time_sensor_ = sensor; }
+  void set_http_read_time_sensor(sensor::Sensor *sensor) { http_read_time_sensor_ = sensor; }
+  void set_rx_overruns_sensor(sensor::Sensor *sensor) { rx_overruns_sensor_ = sensor; }
+  void set_rx_purges_sensor(sensor::Sensor *sensor) { rx_purges_sensor_ = sensor; }
 #endif
 
  protected:
   State state_{State::INIT};
+  State last_state_{State::INIT};
+  uint32_t state_transitions_{0};
+  uint32_t state_entered_at_{0};
+  // Time spent in each state since the current HTTP request (or batch) started.
+  uint32_t state_time_[STATE_COUNT]{};
+  // Time spent in each state and results of each command since boot.
+  LatencyHistogram state_latency_[STATE_COUNT];
+  CommandStats command_stats_[static_cast<size_t>(CommandId::COUNT)];
+  bool adaptive_timeouts_{false};
+  bool persist_timeouts_{false};
+  TimeoutEstimates timeout_estimates_;
+  // Whether timeout_estimates_ changed since they were last saved.
+  bool timeout_estimates_changed_{false};
+  bool timeout_estimates_saved_{false};
+  uint32_t last_timeout_save_{0};
+  ESPPreferenceObject timeout_pref_;
+  // Bytes read from UART and CPU time spent handling them.
+  uint32_t rx_bytes_{0};
+  uint32_t rx_time_us_{0};
+  uint32_t rx_overruns_{0};
+  uint32_t rx_purges_{0};
+  int8_t rts_pin_{-1};
+  int8_t cts_pin_{-1};
+  bool http_stats_{false};
   CommandState command_state_;
   WaitState wait_;
-  HttpState http_state_;
+  // Requests are processed in order. The front request is the one being sent.
+  HttpQueue http_queue_;
+  uint32_t http_dropped_count_{0};
+  uint32_t command_allocations_{0};
+  RxBuffer rx_buffer_;
   std::string read_buffer_;
 
+  // Move all available bytes from UART into the RX buffer.
+  void fill_rx_buffer_();
+
   // Read the next response line into the read buffer.
   // Returns true when a line has been read.
   bool read_line_();
 
-  // Read until the read buffer has up to length bytes.
-  // Returns true when the read buffer contains data.
-  bool read_bytes_(const uint16_t length);
+  // Append up to length bytes to out.
+  // Returns true when data has been read.
+  bool read_bytes_(std::string &out, const uint32_t length);
+
+  // Publish the result of +CBC.
+  void handle_battery_response_(const std::string &response);
+
+  // Check the result of +CREG?. Returns false if not registered.
+  bool handle_registration_response_(const std::string &response);
+
+  // Publish the result of +CSQ.
+  void handle_signal_quality_response_(const std::string &response);
+
+  // Log statistics of a finished request as a single JSON line.
+  void log_http_stats_(const HttpRequest &request);
+
+  // Add a request to the HTTP queue. Returns nullptr if the queue is full.
+  HttpRequest *queue_http_request_(const std::string &url);
+
+  // Pass an unsolicited line to the matching URC subscriptions. Returns false if none matched.
+  bool dispatch_urc_(const std::string &line);
+
+  // Handlers of the built-in URC subscriptions.
+  void on_registration_urc_(const std::string &line);
+  void on_bearer_deact_urc_(const std::string &line);
+  void on_ready_urc_(const std::string &line);
+  void on_sim_ready_urc_(const std::string &line);
+  void on_socket_lost_urc_(const std::string &line);
+
+  // Whether the socket needs to be connected, closed, written or read.
+  bool socket_work_pending_() const;
+  // socket_send() and socket_close() without the keep-alive check, for the keep-alive connection itself.
+  bool socket_send_(std::string data);
+  void socket_close_();
+
+  // Pass received data to the binary callbacks, then to the string callbacks.
+  void deliver_http_response_(uint16_t status_code, std::string &body);
+  void deliver_http_chunk_(uint32_t offset, std::string &chunk);
+  void deliver_socket_data_(std::string &data);
+
+  // Whether the outbox has entries and its last flush did not fail recently.
+  bool outbox_flush_due_(uint32_t now) const;
+  // Queue one POST with all entries of the outbox.
+  void flush_outbox_();
+  // Remove the sent entries from the outbox if the request succeeded, else retry later.
+  void outbox_flushed_(const HttpRequest &request);
+
+  // Choose the work to start from IDLE: the first IdleJob in declaration order that is due.
+  IdleJob next_idle_job_(uint32_t now);
+  // Collect the status checks that are due for the given number of intervals. Returns how many.
+  uint8_t due_checks_(uint32_t now, uint32_t intervals, CommandId *checks) const;
+  // Whether a queued request can be started with AT+HTTPACTION now. Requests held back by
+  // http_min_interval are skipped, and the first one that can start is moved to the front of the queue.
+  bool http_request_startable_(uint32_t now);
+  // Whether a request for AT+HTTPACTION is queued that waits for http_min_interval.
+  bool http_request_deferred_(uint32_t now);
+  // Returns the last queued GET request to the endpoint of url that was not started yet, or nullptr.
+  HttpRequest *find_queued_get_(const std::string &url);
+  // Whether http_min_interval has passed since the last request to the endpoint of the request.
+  bool http_request_ready_(const HttpRequest &request, uint32_t now) const;
+  void record_endpoint_time_(const HttpRequest &request);
+  // Call the failed callbacks for the request at index in the queue, the front by default.
+  void http_request_failed_(size_t index = 0);
+
+  // Take the statistics snapshot of a request that is sent now.
+  void start_http_request_(HttpRequest &request);
+  // Log and remove the request at index in the queue, the front by default.
+  void finish_http_request_(size_t index = 0);
+  // Whether the request is sent over the keep-alive connection instead of AT+HTTPACTION.
+  bool use_keep_alive_(const HttpRequest &request) const;
+  // Whether queued requests can be written to the keep-alive connection, or it has to be opened.
+  // Like http_request_startable_(), the first request that is ready is moved to keep_alive_sent_.
+  bool keep_alive_work_pending_();
+  void handle_keep_alive_data_(const std::string &data);
+  void complete_keep_alive_response_();
+  // Fail or requeue the requests that were written to the closed keep-alive connection.
+  void keep_alive_closed_(bool connected);
+
+  // Read a prompt, which may not be followed by a line break. Returns true if it was read.
+  bool read_prompt_(const char *prompt);
 
   // Read incoming responses and handle them.
   // Returns false if we are waiting on something.
   bool handle_response_();
 
-  // Write a string to UART.
-  void write_(const std::string &s);
+  // Finish the pending command, record its result and continue with its success or error state.
+  void finish_command_(CommandResult result);
 
-  // Write a string to UART. \r\n will be appended.
-  void write_line_(const std::string &s);
+  // Use the adaptive timeout of the pending command, if enabled.
+  void apply_adaptive_timeout_();
 
-  // Send a command and wait for OK.
-  void await_ok_(const std::string &command, const State success_state, const State error_state,
-                 const uint32_t timeout);
+  // Update the latency estimate of the finished command.
+  void learn_timeout_(CommandResult result);
 
-  // Send a command and wait for OK.
-  void await_ok_(const std::string &command, const State success_state) {
-    this->await_ok_(command, success_state, State::INIT, DEFAULT_COMMAND_TIMEOUT);
+  // Total time in ms spent executing a command since boot.
+  uint32_t command_time_(CommandId id) const {
+    return this->command_stats_[static_cast<size_t>(id)].latency.total;
   }
 
-  // Send a command and wait for OK.
-  void await_ok_(const std::string &command, const State success_state, const State error_state) {
-    this->await_ok_(command, success_state, error_state, DEFAULT_COMMAND_TIMEOUT);
-  }
+  // Log the command and state statistics.
+  void dump_stats_();
 
-  // Send a command and wait for a response, then OK.
-  void await_response_(const std::string &command, State success_state, State error_state, uint32_t timeout);
+  bool flow_control_enabled_() const { return this->rts_pin_ >= 0 && this->cts_pin_ >= 0; }
 
-  // Send a command and wait for a response, then OK.
-  void await_response_(const std::string &command, State success_state, uint32_t timeout) {
-    this->await_response_(command, success_state, State::INIT, timeout);
-  }
+  // Enable hardware flow control in the ESP UART driver, if configured.
+  void setup_flow_control_();
 
-  // Send a command and wait for a response, then OK.
-  void await_response_(const std::string &command, State success_state) {
-    this->await_response_(command, success_state, State::INIT, DEFAULT_COMMAND_TIMEOUT);
-  }
+  // Reconfigure the ESP side of the UART.
+  void set_uart_baud_rate_(uint32_t baud_rate);
 
-  // Send a command and wait for OK, then URC.
-  void await_urc_(const std::string &command, State success_state, State error_state, uint32_t timeout,
-                  uint32_t urc_timeout);
+  // Write a command to UART as "AT" + text + argument + suffix + \r\n.
+  void send_(const AtCommand &command, const char *argument);
 
-  // Send a command and wait for OK, then URC.
-  void await_urc_(const std::string &command, State success_state, State error_state) {
-    this->await_urc_(command, success_state, error_state, DEFAULT_COMMAND_TIMEOUT, DEFAULT_URC_TIMEOUT);
-  }
+  // Send a command and wait until it is complete. What is awaited (OK, response,
+  // URC or prompt) is defined by the command's response kind.
+  void await_(CommandId id, State success_state, State error_state = State::INIT, const char *argument = nullptr);
 
-  // Send a command and wait for data of a specific length, then OK.
-  void await_data_(const std::string &command, uint32_t data_length, State success_state, State error_state,
-                   uint32_t timeout);
+  // Send several commands on one line and wait for a response of each, then a single OK.
+  void await_combined_(const CommandId *ids, uint8_t count, State success_state, State error_state);
 
-  // Send a command and wait for data of a specific length, then OK.
-  void await_data_(const std::string &command, uint32_t data_length, State success_state, State error_state) {
-    this->await_data_(command, data_length, success_state, error_state, DEFAULT_COMMAND_TIMEOUT);
-  }
+  // Send a command and wait for a response, then data of a specific length, then OK.
+  void await_data_(CommandId id, const char *argument, uint32_t data_length, State success_state,
+                   State error_state);
+
+  // Wait for OK (or the final result line) of a command whose input has already been written,
+  // without sending anything.
+  void await_input_ok_(CommandId id, State success_state, State error_state, uint32_t timeout);
 
 #ifdef USE_SENSOR
   sensor::Sensor *signal_strength_sensor_{nullptr};
   sensor::Sensor *battery_level_sensor_{nullptr};
   sensor::Sensor *battery_voltage_sensor_{nullptr};
+  sensor::Sensor *command_errors_sensor_{nullptr};
+  sensor::Sensor *command_timeouts_sensor_{nullptr};
+  sensor::Sensor *bearer_open_time_sensor_{nullptr};
+  sensor::Sensor *http_action_time_sensor_{nullptr};
+  sensor::Sensor *http_read_time_sensor_{nullptr};
+  sensor::Sensor *rx_overruns_sensor_{nullptr};
+  sensor::Sensor *rx_purges_sensor_{nullptr};
 #endif
   CallbackManager<void(uint16_t, std::string &)> http_request_done_callback_;
+  CallbackManager<void(uint32_t, std::string &)> http_response_chunk_callback_;
+  CallbackManager<void(uint16_t, const uint8_t *, size_t)> http_binary_response_callback_;
+  CallbackManager<void(uint32_t, const uint8_t *, size_t)> http_binary_chunk_callback_;
   CallbackManager<void(void)> http_request_failed_callback_;
   std::string pin_;
   std::string apn_;
   std::string apn_user_;
   std::string apn_password_;
-  bool idle_sleep_;
-  bool idle_sleep_active_;
+  bool idle_sleep_{false};
+  bool idle_sleep_active_{false};
+  GPIOPin *dtr_pin_{nullptr};
+  // Whether +CSCLK=1 was sent since the module was initialized.
+  bool dtr_sleep_enabled_{false};
+  // Baud rate of the UART config, which the module autobauds to after a reboot.
+  uint32_t initial_baud_rate_{0};
+  uint32_t target_baud_rate_{0};
+  // Set when switching to the target baud rate failed, to not try again until reboot.
+  bool baud_rate_failed_{false};
+  // Whether the cold initialization has finished.
+  bool initialized_{false};
+  uint32_t battery_check_interval_{0};
+  uint32_t registration_check_interval_{0};
+  uint32_t signal_check_interval_{0};
+  uint32_t last_battery_check_{0};
+  uint32_t last_registration_check_{0};
+  uint32_t last_signal_check_{0};
+  // Set by +CPIN: READY, Call Ready and SMS Ready after the module has started.
+  bool sim_ready_{false};
+  uint32_t last_pin_check_{0};
+  // Last registration status, updated by +CREG: responses and URCs.
+  bool registered_{false};
+  std::vector<UrcSubscription> urc_subscriptions_;
+  SocketStatus socket_status_{SocketStatus::CLOSED};
+  SocketProtocol socket_protocol_{SocketProtocol::TCP};
+  std::string socket_host_;
+  uint16_t socket_port_{0};
+  // Set by +CIPRXGET: 1 when the module has received data that was not fetched yet.
+  bool socket_rx_pending_{false};
+  std::deque<std::string> socket_tx_queue_;
+  CallbackManager<void()> socket_connected_callback_;
+  CallbackManager<void(std::string &)> socket_data_callback_;
+  CallbackManager<void(const uint8_t *, size_t)> socket_binary_data_callback_;
+  CallbackManager<void()> socket_closed_callback_;
+  HttpCoalesce http_coalesce_{HttpCoalesce::NONE};
+  uint32_t http_min_interval_{0};
+  std::vector<EndpointTime> endpoint_times_;
+  uint32_t http_coalesced_count_{0};
+  Outbox outbox_;
+  std::string outbox_url_;
+  std::string outbox_content_type_;
+  uint8_t outbox_size_{0};
+  // Whether a POST with outbox entries is queued or pending.
+  bool outbox_flushing_{false};
+  uint32_t outbox_next_flush_{0};
+  bool http_keep_alive_{false};
+  // Whether the socket was opened for HTTP keep-alive and not by socket_connect().
+  bool socket_keep_alive_{false};
+  // Number of requests at the front of the queue written to the keep-alive connection without a response yet.
+  uint8_t keep_alive_sent_{0};
+  uint32_t keep_alive_activity_{0};
+  HttpResponseParser keep_alive_parser_;
+  bool bearer_open_{false};
+  uint32_t keep_bearer_open_{0};
+  uint32_t bearer_idle_since_{0};
+  bool stream_response_{false};
+  uint16_t response_chunk_size_{DEFAULT_RESPONSE_CHUNK_SIZE};
 };
 
+// Triggers with the result of one http_get action, also when it was coalesced with other requests.
+class HttpResponseTrigger : public Trigger<uint16_t, std::string &> {};
+
 template<typename... Ts> class HttpGetAction : public Action<Ts...> {
  public:
   HttpGetAction(Sim800LDataComponent *parent) : parent_(parent) {}
   TEMPLATABLE_VALUE(std::string, url)
+  void add_response_trigger(HttpResponseTrigger *trigger) { this->response_triggers_.push_back(trigger); }
 
   void play(Ts... x) {
     auto url = this->url_.value(x...);
-    this->parent_->http_get(url);
+    if (this->response_triggers_.empty()) {
+      this->parent_->http_get(url);
+      return;
+    }
+    this->parent_->http_get(url, [this](uint16_t status_code, std::string &response_body) {
+      for (auto *trigger : this->response_triggers_) {
+        trigger->trigger(status_code, response_body);
+      }
+    });
+  }
+
+ protected:
+  Sim800LDataComponent *parent_;
+  std::vector<HttpResponseTrigger *> response_triggers_;
+};
+
+template<typename... Ts> class HttpPostAction : public Action<Ts...> {
+ public:
+  HttpPostAction(Sim800LDataComponent *parent) : parent_(parent) {}
+  TEMPLATABLE_VALUE(std::string, url)
+  TEMPLATABLE_VALUE(std::string, content_type)
+  TEMPLATABLE_VALUE(std::string, body)
+
+  void play(Ts... x) {
+    auto url = this->url_.value(x...);
+    auto content_type = this->content_type_.value(x...);
+    auto body = this->body_.value(x...);
+    this->parent_->http_post(url, content_type, std::move(body));
+  }
+
+ protected:
+  Sim800LDataComponent *parent_;
+};
+
+template<typename... Ts> class OutboxAddAction : public Action<Ts...> {
+ public:
+  OutboxAddAction(Sim800LDataComponent *parent) : parent_(parent) {}
+  TEMPLATABLE_VALUE(std::string, payload)
+
+  void play(Ts... x) { this->parent_->outbox_add(this->payload_.value(x...)); }
+
+ protected:
+  Sim800LDataComponent *parent_;
+};
+
+template<typename... Ts> class SocketConnectAction : public Action<Ts...> {
+ public:
+  SocketConnectAction(Sim800LDataComponent *parent) : parent_(parent) {}
+  TEMPLATABLE_VALUE(std::string, host)
+  TEMPLATABLE_VALUE(uint16_t, port)
+  void set_protocol(SocketProtocol protocol) { this->protocol_ = protocol; }
+
+  void play(Ts... x) {
+    auto host = this->host_.value(x...);
+    auto port = this->port_.value(x...);
+    this->parent_->socket_connect(this->protocol_, host, port);
   }
 
+ protected:
+  Sim800LDataComponent *parent_;
+  SocketProtocol protocol_{SocketProtocol::TCP};
+};
+
+template<typename... Ts> class SocketSendAction : public Action<Ts...> {
+ public:
+  SocketSendAction(Sim800LDataComponent *parent) : parent_(parent) {}
+  TEMPLATABLE_VALUE(std::string, data)
+
+  void play(Ts... x) { this->parent_->socket_send(this->data_.value(x...)); }
+
+ protected:
+  Sim800LDataComponent *parent_;
+};
+
+template<typename... Ts> class SocketCloseAction : public Action<Ts...> {
+ public:
+  SocketCloseAction(Sim800LDataComponent *parent) : parent_(parent) {}
+
+  void play(Ts... x) { this->parent_->socket_close(); }
+
  protected:
   Sim800LDataComponent *parent_;
 };
@@ -148,6 +512,32 @@ class HttpRequestDoneTrigger : public Trigger<uint16_t, std::string &> {
   }
 };
 
+class HttpResponseChunkTrigger : public Trigger<uint32_t, std::string &> {
+ public:
+  explicit HttpResponseChunkTrigger(Sim800LDataComponent *parent) {
+    parent->add_on_http_response_chunk_callback(
+        [this](uint32_t offset, std::string &chunk) { this->trigger(offset, chunk); });
+  }
+};
+
+class HttpBinaryResponseTrigger : public Trigger<uint16_t, std::vector<uint8_t>> {
+ public:
+  explicit HttpBinaryResponseTrigger(Sim800LDataComponent *parent) {
+    parent->add_on_http_binary_response_callback([this](uint16_t status_code, const uint8_t *data, size_t length) {
+      this->trigger(status_code, std::vector<uint8_t>(data, data + length));
+    });
+  }
+};
+
+class HttpBinaryChunkTrigger : public Trigger<uint32_t, std::vector<uint8_t>> {
+ public:
+  explicit HttpBinaryChunkTrigger(Sim800LDataComponent *parent) {
+    parent->add_on_http_binary_chunk_callback([this](uint32_t offset, const uint8_t *data, size_t length) {
+      this->trigger(offset, std::vector<uint8_t>(data, data + length));
+    });
+  }
+};
+
 class HttpRequestFailedTrigger : public Trigger<> {
  public:
   explicit HttpRequestFailedTrigger(Sim800LDataComponent *parent) {
@@ -155,5 +545,34 @@ class HttpRequestFailedTrigger : public Trigger<> {
   }
 };
 
+class SocketConnectedTrigger : public Trigger<> {
+ public:
+  explicit SocketConnectedTrigger(Sim800LDataComponent *parent) {
+    parent->add_on_socket_connected_callback([this]() { this->trigger(); });
+  }
+};
+
+class SocketDataTrigger : public Trigger<std::string &> {
+ public:
+  explicit SocketDataTrigger(Sim800LDataComponent *parent) {
+    parent->add_on_socket_data_callback([this](std::string &data) { this->trigger(data); });
+  }
+};
+
+class SocketBinaryDataTrigger : public Trigger<std::vector<uint8_t>> {
+ public:
+  explicit SocketBinaryDataTrigger(Sim800LDataComponent *parent) {
+    parent->add_on_socket_binary_data_callback(
+        [this](const uint8_t *data, size_t length) { this->trigger(std::vector<uint8_t>(data, data + length)); });
+  }
+};
+
+class SocketClosedTrigger : public Trigger<> {
+ public:
+  explicit SocketClosedTrigger(Sim800LDataComponent *parent) {
+    parent->add_on_socket_closed_callback([this]() { this->trigger(); });
+  }
+};
+
 }  // namespace sim800l_data
 }  // namespace esphome
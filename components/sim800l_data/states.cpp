@@ -1,26 +1,289 @@
 #include "states.h"
+
+#include <cstdlib>
+#include <utility>
+
 namespace esphome {
 namespace sim800l_data {
 
-void CommandState::reset(const std::string &command, State success_state, State error_state, uint32_t timeout) {
-  this->command = command;
+const char *state_to_string(State state) {
+  switch (state) {
+    case State::INIT:
+      return "INIT";
+    case State::WAKE:
+      return "WAKE";
+    case State::DISABLE_ECHO:
+      return "DISABLE_ECHO";
+    case State::SYNC_BAUD_RATE:
+      return "SYNC_BAUD_RATE";
+    case State::SET_BAUD_RATE:
+      return "SET_BAUD_RATE";
+    case State::SWITCH_BAUD_RATE:
+      return "SWITCH_BAUD_RATE";
+    case State::CHECK_BAUD_RATE:
+      return "CHECK_BAUD_RATE";
+    case State::BAUD_RATE_FAILED:
+      return "BAUD_RATE_FAILED";
+    case State::ENABLE_FLOW_CONTROL:
+      return "ENABLE_FLOW_CONTROL";
+    case State::DISABLE_SLEEP:
+      return "DISABLE_SLEEP";
+    case State::CHECK_BATTERY:
+      return "CHECK_BATTERY";
+    case State::CHECK_BATTERY_RESPONSE:
+      return "CHECK_BATTERY_RESPONSE";
+    case State::CHECK_PIN:
+      return "CHECK_PIN";
+    case State::CHECK_PIN_RESPONSE:
+      return "CHECK_PIN_RESPONSE";
+    case State::WAIT_SIM_READY:
+      return "WAIT_SIM_READY";
+    case State::WRONG_PIN:
+      return "WRONG_PIN";
+    case State::SET_CONTYPE_GRPS:
+      return "SET_CONTYPE_GRPS";
+    case State::SET_APN:
+      return "SET_APN";
+    case State::SET_APN_USER:
+      return "SET_APN_USER";
+    case State::SET_APN_PWD:
+      return "SET_APN_PWD";
+    case State::ENABLE_REGISTRATION_URC:
+      return "ENABLE_REGISTRATION_URC";
+    case State::CHECK_REGISTRATION:
+      return "CHECK_REGISTRATION";
+    case State::CHECK_REGISTRATION_RESPONSE:
+      return "CHECK_REGISTRATION_RESPONSE";
+    case State::WAIT_REGISTRATION:
+      return "WAIT_REGISTRATION";
+    case State::CHECK_SIGNAL_QUALITY:
+      return "CHECK_SIGNAL_QUALITY";
+    case State::CHECK_SIGNAL_QUALITY_RESPONSE:
+      return "CHECK_SIGNAL_QUALITY_RESPONSE";
+    case State::CHECK_STATUS_RESPONSE:
+      return "CHECK_STATUS_RESPONSE";
+    case State::IDLE:
+      return "IDLE";
+    case State::ENABLE_SLEEP:
+      return "ENABLE_SLEEP";
+    case State::FATAL:
+      return "FATAL";
+    case State::HTTP_CHECK_BEARER:
+      return "HTTP_CHECK_BEARER";
+    case State::HTTP_CHECK_BEARER_RESPONSE:
+      return "HTTP_CHECK_BEARER_RESPONSE";
+    case State::HTTP_INIT:
+      return "HTTP_INIT";
+    case State::HTTP_SET_BEARER:
+      return "HTTP_SET_BEARER";
+    case State::HTTP_OPEN_BEARER:
+      return "HTTP_OPEN_BEARER";
+    case State::HTTP_START_REQUEST:
+      return "HTTP_START_REQUEST";
+    case State::HTTP_SET_SSL:
+      return "HTTP_SET_SSL";
+    case State::HTTP_SET_URL:
+      return "HTTP_SET_URL";
+    case State::HTTP_SET_CONTENT:
+      return "HTTP_SET_CONTENT";
+    case State::HTTP_DATA:
+      return "HTTP_DATA";
+    case State::HTTP_WRITE_BODY:
+      return "HTTP_WRITE_BODY";
+    case State::HTTP_ACTION:
+      return "HTTP_ACTION";
+    case State::HTTP_ACTION_RESPONSE:
+      return "HTTP_ACTION_RESPONSE";
+    case State::HTTP_READ_RESPONSE:
+      return "HTTP_READ_RESPONSE";
+    case State::HTTP_READ_CHUNK:
+      return "HTTP_READ_CHUNK";
+    case State::HTTP_READ_CHUNK_RESPONSE:
+      return "HTTP_READ_CHUNK_RESPONSE";
+    case State::HTTP_FAILED:
+      return "HTTP_FAILED";
+    case State::HTTP_NEXT_REQUEST:
+      return "HTTP_NEXT_REQUEST";
+    case State::HTTP_TERM:
+      return "HTTP_TERM";
+    case State::HTTP_CLOSE_BEARER:
+      return "HTTP_CLOSE_BEARER";
+    case State::HTTP_KEEP_ALIVE:
+      return "HTTP_KEEP_ALIVE";
+    case State::SOCKET_SHUT:
+      return "SOCKET_SHUT";
+    case State::SOCKET_MANUAL_RECEIVE:
+      return "SOCKET_MANUAL_RECEIVE";
+    case State::SOCKET_SET_APN:
+      return "SOCKET_SET_APN";
+    case State::SOCKET_BRING_UP:
+      return "SOCKET_BRING_UP";
+    case State::SOCKET_GET_IP:
+      return "SOCKET_GET_IP";
+    case State::SOCKET_CONNECT:
+      return "SOCKET_CONNECT";
+    case State::SOCKET_CONNECTED:
+      return "SOCKET_CONNECTED";
+    case State::SOCKET_SEND:
+      return "SOCKET_SEND";
+    case State::SOCKET_WRITE_DATA:
+      return "SOCKET_WRITE_DATA";
+    case State::SOCKET_SENT:
+      return "SOCKET_SENT";
+    case State::SOCKET_RECEIVE:
+      return "SOCKET_RECEIVE";
+    case State::SOCKET_RECEIVE_RESPONSE:
+      return "SOCKET_RECEIVE_RESPONSE";
+    case State::SOCKET_FAILED:
+      return "SOCKET_FAILED";
+    case State::SOCKET_CLOSE:
+      return "SOCKET_CLOSE";
+    case State::SOCKET_SHUT_GPRS:
+      return "SOCKET_SHUT_GPRS";
+    case State::SOCKET_CLOSED:
+      return "SOCKET_CLOSED";
+  }
+  return "UNKNOWN";
+}
+
+void CommandState::reset(const AtCommand &command, State success_state, State error_state) {
+  for (uint8_t i = 0; i < MAX_COMBINED_COMMANDS; i++) {
+    this->capacity_[i] = this->responses[i].capacity();
+    this->responses[i].clear();
+  }
+  this->capacity_[MAX_COMBINED_COMMANDS] = this->urc.capacity();
+  this->capacity_[MAX_COMBINED_COMMANDS + 1] = this->data.capacity();
+  this->command = &command;
+  this->commands[0] = &command;
+  this->command_count = 1;
+  this->adaptive = false;
   this->success_state = success_state;
   this->error_state = error_state;
-  this->timeout = timeout;
-  this->urc_timeout = DEFAULT_URC_TIMEOUT;
-  this->ok_received = false;
-  this->response_required = false;
-  this->response.clear();
-  this->response.shrink_to_fit();
-  this->urc_required = false;
+  this->timeout = command.timeout;
+  this->urc_timeout = command.urc_timeout;
+  // Commands with a final result line other than OK never send OK
+  this->ok_received = command.kind == ResponseKind::FINAL;
+  this->response_required = command.kind == ResponseKind::RESPONSE || command.kind == ResponseKind::DATA;
+  this->urc_required = command.kind == ResponseKind::URC || command.kind == ResponseKind::FINAL;
   this->urc.clear();
   this->data_required = 0;
   this->data.clear();
-  this->data.shrink_to_fit();
+  this->prompt_required = command.kind == ResponseKind::PROMPT;
   this->is_pending = false;
   this->start = 0;
 }
 
+void CommandState::add_command(const AtCommand &command) {
+  this->commands[this->command_count++] = &command;
+  this->timeout = std::max(this->timeout, command.timeout);
+}
+
+void LatencyHistogram::add(uint32_t duration) {
+  size_t bucket = 0;
+  while (bucket < LATENCY_BUCKET_COUNT - 1 && duration >= LATENCY_BUCKET_BOUNDS[bucket]) {
+    bucket++;
+  }
+  this->buckets[bucket]++;
+  this->count++;
+  this->total += duration;
+  this->max = std::max(this->max, duration);
+}
+
+void LatencyHistogram::format(char *buffer, size_t size) const {
+  int length = 0;
+  for (size_t i = 0; i < LATENCY_BUCKET_COUNT && length >= 0 && static_cast<size_t>(length) < size; i++) {
+    if (i < LATENCY_BUCKET_COUNT - 1) {
+      length += snprintf(buffer + length, size - length, "%s<%u:%u", i > 0 ? " " : "", LATENCY_BUCKET_BOUNDS[i],
+                         this->buckets[i]);
+    } else {
+      length += snprintf(buffer + length, size - length, " >=%u:%u", LATENCY_BUCKET_BOUNDS[i - 1], this->buckets[i]);
+    }
+  }
+}
+
+void LatencyEstimate::add(uint32_t duration) {
+  if (this->samples == 0) {
+    this->mean = duration;
+    this->deviation = duration / 2;
+  } else {
+    const int32_t error = static_cast<int32_t>(duration - this->mean);
+    this->mean += error / 8;
+    this->deviation += (static_cast<int32_t>(std::abs(error)) - static_cast<int32_t>(this->deviation)) / 4;
+  }
+  if (this->samples < UINT16_MAX) {
+    this->samples++;
+  }
+}
+
+uint32_t LatencyEstimate::timeout(uint32_t max) const {
+  if (this->samples < ADAPTIVE_TIMEOUT_MIN_SAMPLES) {
+    return max;
+  }
+  const uint32_t timeout = this->mean + 4 * this->deviation;
+  return std::min(max, std::max(MIN_ADAPTIVE_TIMEOUT, timeout));
+}
+
+void CommandStats::add(CommandResult result, uint32_t runtime) {
+  this->latency.add(runtime);
+  switch (result) {
+    case CommandResult::SUCCESS:
+      this->successes++;
+      break;
+    case CommandResult::ERROR:
+      this->errors++;
+      break;
+    case CommandResult::TIMEOUT:
+      this->timeouts++;
+      break;
+  }
+}
+
+bool CommandState::add_response(const std::string &line) {
+  for (uint8_t i = 0; i < this->command_count; i++) {
+    if (this->responses[i].empty() && this->commands[i]->matches(line)) {
+      this->responses[i] = line;
+      return true;
+    }
+  }
+  return false;
+}
+
+const std::string *CommandState::response_of(CommandId id) const {
+  for (uint8_t i = 0; i < this->command_count; i++) {
+    if (this->commands[i]->id == id) {
+      return &this->responses[i];
+    }
+  }
+  return nullptr;
+}
+
+bool CommandState::response_received() const {
+  for (uint8_t i = 0; i < this->command_count; i++) {
+    if (this->responses[i].empty()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void CommandState::reserve() {
+  for (auto &response : this->responses) {
+    response.reserve(RESPONSE_BUFFER_SIZE);
+  }
+  this->urc.reserve(RESPONSE_BUFFER_SIZE);
+  this->data.reserve(DEFAULT_RESPONSE_CHUNK_SIZE);
+}
+
+uint8_t CommandState::allocations() const {
+  uint8_t allocations = 0;
+  for (uint8_t i = 0; i < MAX_COMBINED_COMMANDS; i++) {
+    allocations += this->responses[i].capacity() > this->capacity_[i];
+  }
+  allocations += this->urc.capacity() > this->capacity_[MAX_COMBINED_COMMANDS];
+  allocations += this->data.capacity() > this->capacity_[MAX_COMBINED_COMMANDS + 1];
+  return allocations;
+}
+
 bool CommandState::timed_out() const {
   const uint32_t runtime = this->runtime();
   if (!this->ok_received && runtime > this->timeout) {
@@ -50,13 +313,62 @@ bool WaitState::is_waiting() {
   return false;
 }
 
-void HttpState::reset() {
-  this->state = NONE;
+void HttpRequest::reset() {
+  this->state = QUEUED;
+  this->method = GET;
+  this->ssl = false;
   this->url.clear();
-  this->url.shrink_to_fit();
+  this->content_type.clear();
+  this->body_size = 0;
+  this->body_offset = 0;
+  this->body_provider = nullptr;
+  this->body_failed = false;
   this->status_code = 0;
-  this->response_data.clear();
-  this->response_data.shrink_to_fit();
+  this->endpoint_hash = 0;
+  this->callbacks.clear();
+  this->content_length = 0;
+  this->read_offset = 0;
+  this->retried = false;
+  this->outbox_sequence = 0;
+  this->start = {};
+}
+
+void HttpQueue::set_capacity(size_t capacity) {
+  this->slots_.resize(capacity);
+  this->head_ = 0;
+  this->size_ = 0;
+}
+
+HttpRequest &HttpQueue::push() {
+  HttpRequest &request = this->slots_[(this->head_ + this->size_) % this->slots_.size()];
+  request.reset();
+  this->size_++;
+  return request;
+}
+
+void HttpQueue::pop() {
+  this->slots_[this->head_].body_provider = nullptr;
+  this->head_ = (this->head_ + 1) % this->slots_.size();
+  this->size_--;
+}
+
+void HttpQueue::remove(size_t index) {
+  if (index == 0) {
+    this->pop();
+    return;
+  }
+  // Swap the removed slot to the end, so the slots keep their buffers
+  for (size_t i = index; i + 1 < this->size_; i++) {
+    std::swap(this->at(i), this->at(i + 1));
+  }
+  this->at(this->size_ - 1).body_provider = nullptr;
+  this->size_--;
+}
+
+void HttpQueue::move_to(size_t from, size_t to) {
+  for (size_t i = from; i > to; i--) {
+    std::swap(this->at(i), this->at(i - 1));
+  }
 }
 
 }  // namespace sim800l_data
@@ -1,71 +1,191 @@
 #pragma once
 
+#include <algorithm>
+
 #include "esphome/core/helpers.h"
 #include "esphome/core/log.h"
 #include "esphome/core/hal.h"
 
 #include "constants.h"
+#include "commands.h"
 
 namespace esphome {
 namespace sim800l_data {
 
 enum class State : uint8_t {
   INIT,
+  WAKE,
   DISABLE_ECHO,
+  SYNC_BAUD_RATE,
+  SET_BAUD_RATE,
+  SWITCH_BAUD_RATE,
+  CHECK_BAUD_RATE,
+  BAUD_RATE_FAILED,
+  ENABLE_FLOW_CONTROL,
   DISABLE_SLEEP,
   CHECK_BATTERY,
   CHECK_BATTERY_RESPONSE,
   CHECK_PIN,
   CHECK_PIN_RESPONSE,
+  WAIT_SIM_READY,
   WRONG_PIN,
   SET_CONTYPE_GRPS,
   SET_APN,
   SET_APN_USER,
   SET_APN_PWD,
+  ENABLE_REGISTRATION_URC,
   CHECK_REGISTRATION,
   CHECK_REGISTRATION_RESPONSE,
+  WAIT_REGISTRATION,
   CHECK_SIGNAL_QUALITY,
   CHECK_SIGNAL_QUALITY_RESPONSE,
+  CHECK_STATUS_RESPONSE,
   IDLE,
   ENABLE_SLEEP,
   FATAL,
 
+  HTTP_CHECK_BEARER,
+  HTTP_CHECK_BEARER_RESPONSE,
   HTTP_INIT,
-  HTTP_SET_SSL,
   HTTP_SET_BEARER,
   HTTP_OPEN_BEARER,
+  HTTP_START_REQUEST,
+  HTTP_SET_SSL,
   HTTP_SET_URL,
+  HTTP_SET_CONTENT,
+  HTTP_DATA,
+  HTTP_WRITE_BODY,
   HTTP_ACTION,
   HTTP_ACTION_RESPONSE,
   HTTP_READ_RESPONSE,
+  HTTP_READ_CHUNK,
+  HTTP_READ_CHUNK_RESPONSE,
   HTTP_FAILED,
+  HTTP_NEXT_REQUEST,
   HTTP_TERM,
-  HTTP_CLOSE_BEARER
+  HTTP_CLOSE_BEARER,
+  HTTP_KEEP_ALIVE,
+  SOCKET_SHUT,
+  SOCKET_MANUAL_RECEIVE,
+  SOCKET_SET_APN,
+  SOCKET_BRING_UP,
+  SOCKET_GET_IP,
+  SOCKET_CONNECT,
+  SOCKET_CONNECTED,
+  SOCKET_SEND,
+  SOCKET_WRITE_DATA,
+  SOCKET_SENT,
+  SOCKET_RECEIVE,
+  SOCKET_RECEIVE_RESPONSE,
+  SOCKET_FAILED,
+  SOCKET_CLOSE,
+  SOCKET_SHUT_GPRS,
+  SOCKET_CLOSED
+};
+
+// Number of states. SOCKET_CLOSED must stay the last state.
+static constexpr size_t STATE_COUNT = static_cast<size_t>(State::SOCKET_CLOSED) + 1;
+
+// Returns the name of a state for logging.
+const char *state_to_string(State state);
+
+enum class CommandResult : uint8_t { SUCCESS, ERROR, TIMEOUT };
+
+// Fixed-bucket histogram of durations in ms.
+struct LatencyHistogram {
+  uint32_t buckets[LATENCY_BUCKET_COUNT]{};
+  uint32_t count{0};
+  uint32_t total{0};
+  uint32_t max{0};
+
+  void add(uint32_t duration);
+
+  // Writes the bucket counts as "<100:3 <500:1 ..." for logging.
+  void format(char *buffer, size_t size) const;
+};
+
+// Results and latencies of all executions of one command.
+struct CommandStats {
+  LatencyHistogram latency;
+  uint32_t successes{0};
+  uint32_t errors{0};
+  uint32_t timeouts{0};
+
+  void add(CommandResult result, uint32_t runtime);
+};
+
+// Running estimate of a command's latency: EWMA of the mean and the mean deviation,
+// the same way TCP estimates its retransmission timeout.
+struct LatencyEstimate {
+  uint32_t mean{0};
+  uint32_t deviation{0};
+  uint16_t samples{0};
+
+  void add(uint32_t duration);
+
+  // Timeout of mean + 4 * deviation, clamped to max. Returns max until enough samples are known.
+  uint32_t timeout(uint32_t max) const;
+};
+
+// Estimates of the commands with adaptive timeouts, stored in flash as one block.
+struct TimeoutEstimates {
+  LatencyEstimate commands[ADAPTIVE_COMMAND_COUNT];
+
+  // The estimate of a command, or nullptr if its timeout is not adaptive.
+  LatencyEstimate *find(CommandId id) {
+    const uint8_t index = ADAPTIVE_TIMEOUT_INDEX.index[static_cast<size_t>(id)];
+    return index == NO_ADAPTIVE_TIMEOUT ? nullptr : &this->commands[index];
+  }
+  const LatencyEstimate *find(CommandId id) const { return const_cast<TimeoutEstimates *>(this)->find(id); }
 };
 
 class CommandState {
  public:
-  std::string command;
+  // The first command. Several commands can be sent on one line; they have one
+  // response each, then a single OK.
+  const AtCommand *command{&COMMANDS[0]};
+  const AtCommand *commands[MAX_COMBINED_COMMANDS];
+  uint8_t command_count;
   State success_state;
   State error_state;
   uint32_t timeout;
   uint32_t urc_timeout;
   bool ok_received;
   bool response_required;
-  std::string response;
+  std::string responses[MAX_COMBINED_COMMANDS];
   bool urc_required;
   std::string urc;
   uint32_t data_required;
   std::string data;
-  bool is_pending;
+  bool prompt_required;
+  bool is_pending{false};
+  // Whether the timeout was taken from the latency estimate of the command.
+  bool adaptive;
   uint32_t start;
 
-  void reset(const std::string &command = "", State success_state = State::INIT, State error_state = State::INIT,
-             uint32_t timeout = DEFAULT_COMMAND_TIMEOUT);
+  // Reset for the next command. What is required to complete it is taken from the
+  // command's response kind. Buffers are cleared, but keep their capacity.
+  void reset(const AtCommand &command, State success_state, State error_state);
+
+  // Add another command to be sent on the same line. It must be of kind RESPONSE.
+  void add_command(const AtCommand &command);
+
+  // Store the line if it is a missing response of one of the commands.
+  // Returns false if the line is not a response.
+  bool add_response(const std::string &line);
+
+  // Returns the response of the given command, or nullptr if it was not sent.
+  const std::string *response_of(CommandId id) const;
+
+  // Allocate the buffers up front.
+  void reserve();
+
+  // Number of buffers that had to grow since the last reset.
+  uint8_t allocations() const;
 
   uint32_t runtime() const { return millis() - start; }
 
-  bool response_received() const { return !this->response.empty(); }
+  bool response_received() const;
 
   bool data_complete() const { return this->data.size() == this->data_required; }
 
@@ -77,12 +197,15 @@ class CommandState {
   }
 
   bool timed_out() const;
+
+ protected:
+  size_t capacity_[MAX_COMBINED_COMMANDS + 2]{};
 };
 
 class WaitState {
  protected:
-  uint32_t started_;
-  uint32_t timeout_;
+  uint32_t started_{0};
+  uint32_t timeout_{0};
 
  public:
   // Wait before the next command is executed.
@@ -92,17 +215,124 @@ class WaitState {
   bool is_waiting();
 };
 
-class HttpState {
+enum class SocketProtocol : uint8_t { TCP, UDP };
+
+enum class SocketStatus : uint8_t {
+  CLOSED,
+  CONNECT_REQUESTED,  // socket_connect() was called, connecting starts from IDLE
+  CONNECTING,
+  CONNECTED,
+  CLOSE_REQUESTED,  // socket_close() was called or the connection was lost
+};
+
+// Callback for unsolicited lines starting with prefix.
+struct UrcSubscription {
+  const char *prefix;
+  size_t prefix_length;
+  std::function<void(const std::string &)> callback;
+};
+
+// Work started from IDLE, in order of priority. Sim800LDataComponent::next_idle_job_() checks them in this order.
+enum class IdleJob : uint8_t {
+  NONE,
+  REGISTRATION_LOST,
+  OVERDUE_CHECKS,  // status checks past their deadline
+  SOCKET,
+  KEEP_ALIVE,
+  HTTP_REQUEST,
+  CHECKS,  // status checks that are due, deferred while there is traffic
+  BEARER_CLOSE,
+  OUTBOX,
+  KEEP_ALIVE_CLOSE,
+  SLEEP,
+};
+
+// How http_get() combines a request with a queued request to the same endpoint (URL without query).
+enum class HttpCoalesce : uint8_t {
+  NONE,         // queue every request
+  LATEST,       // the new URL replaces the queued one
+  MERGE_QUERY,  // the query parameters of both are merged, the new values win
+};
+
+// Called with the result of one http_get() call. status_code is 0 and body empty if the request failed.
+using HttpResultCallback = std::function<void(uint16_t status_code, std::string &body)>;
+
+// When a request to an endpoint was last started, for http_min_interval.
+struct EndpointTime {
+  uint32_t hash;
+  uint32_t started_at;
+};
+
+// Writes up to length bytes of the request body at offset into buffer.
+// Returns the number of bytes written.
+using HttpBodyProvider = std::function<size_t(uint32_t offset, uint8_t *buffer, size_t length)>;
+
+class HttpRequest {
  public:
-  enum { NONE, QUEUED, PENDING } state{NONE};
-  enum { GET } method{GET};
-  bool ssl;
+  enum { QUEUED, PENDING } state{QUEUED};
+  enum { GET, POST } method{GET};
+  bool ssl{false};
   std::string url;
-  uint16_t status_code;
-  std::string response_data;
+  std::string content_type;
+  uint32_t body_size{0};
+  uint32_t body_offset{0};
+  HttpBodyProvider body_provider;
+  // Set when the body provider failed. The rest of the body is padded, then the request fails.
+  bool body_failed{false};
+  uint16_t status_code{0};
+  // Hash of the URL without query, to find requests to the same endpoint.
+  uint32_t endpoint_hash{0};
+  // Callbacks of all http_get() calls that were coalesced into this request.
+  std::vector<HttpResultCallback> callbacks;
+  // Body length reported by +HTTPACTION and how much of it was read so far (streaming only).
+  uint32_t content_length{0};
+  uint32_t read_offset{0};
+  // Set when the keep-alive connection closed before the response arrived, so it is only retried once.
+  bool retried{false};
+  // Sequence number of the newest outbox entry in the body, 0 if it is no outbox request.
+  // The entries up to it are removed from the outbox when the request succeeds.
+  uint32_t outbox_sequence{0};
+  // When the request was queued and started, and the component's counters at start.
+  struct {
+    uint32_t queued_at;
+    uint32_t started_at;
+    uint32_t transitions;
+    uint32_t rx_bytes;
+    uint32_t rx_time_us;
+    uint32_t allocations;
+  } start{};
 
+  // Reset for the next request. Strings are cleared, but keep their capacity.
   void reset();
 };
 
+// Fixed-capacity FIFO of HTTP requests. The slots are allocated once and reused.
+class HttpQueue {
+ public:
+  void set_capacity(size_t capacity);
+  size_t capacity() const { return this->slots_.size(); }
+  size_t size() const { return this->size_; }
+  bool empty() const { return this->size_ == 0; }
+  bool full() const { return this->size_ >= this->slots_.size(); }
+
+  HttpRequest &front() { return this->slots_[this->head_]; }
+  HttpRequest &at(size_t index) { return this->slots_[(this->head_ + index) % this->slots_.size()]; }
+
+  // Reset the next free slot and add it to the end of the queue. The queue must not be full.
+  HttpRequest &push();
+
+  // Remove the front request.
+  void pop();
+  // Remove the request at index. The requests behind it move forward.
+  void remove(size_t index);
+  // Move the request at from forward to index to. The requests in between move back by one.
+  void move_to(size_t from, size_t to);
+
+ protected:
+  std::vector<HttpRequest> slots_;
+  size_t head_{0};
+  size_t size_{0};
+};
+
 }  // namespace sim800l_data
 }  // namespace esphome
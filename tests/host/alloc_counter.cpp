@@ -0,0 +1,12 @@
+#include "alloc_counter.h"
+
+namespace esphome {
+namespace sim800l_data {
+namespace testing {
+
+AllocationCounter allocations;
+int UncountedAllocations::depth = 0;
+
+}  // namespace testing
+}  // namespace sim800l_data
+}  // namespace esphome
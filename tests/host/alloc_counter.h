@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace esphome {
+namespace sim800l_data {
+namespace testing {
+
+// Heap usage, counted by the replaced operator new of the benchmark. Stays 0 in the tests.
+struct AllocationCounter {
+  uint64_t count{0};
+  uint64_t bytes{0};
+  // Bytes allocated and not freed yet, and the maximum of it since reset_peak()
+  int64_t current{0};
+  int64_t peak{0};
+
+  void reset_peak() { this->peak = this->current; }
+};
+
+extern AllocationCounter allocations;
+
+// Allocations made while an instance exists are not counted, e.g. the ones of the emulator.
+class UncountedAllocations {
+ public:
+  UncountedAllocations() { depth++; }
+  ~UncountedAllocations() { depth--; }
+  static bool active() { return depth > 0; }
+
+ protected:
+  static int depth;
+};
+
+}  // namespace testing
+}  // namespace sim800l_data
+}  // namespace esphome
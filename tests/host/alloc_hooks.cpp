@@ -0,0 +1,55 @@
+// Replaces the global operator new and delete to count the allocations of the component.
+// Only linked into the benchmark.
+#include <cstdlib>
+#include <new>
+
+#include "alloc_counter.h"
+
+using esphome::sim800l_data::testing::allocations;
+using esphome::sim800l_data::testing::UncountedAllocations;
+
+namespace {
+
+// Stored in front of each allocation, so delete knows what to subtract
+struct alignas(alignof(std::max_align_t)) Header {
+  size_t size;
+  bool counted;
+};
+
+void *allocate(size_t size) {
+  auto *header = static_cast<Header *>(malloc(sizeof(Header) + size));
+  if (header == nullptr) {
+    throw std::bad_alloc();
+  }
+  header->size = size;
+  header->counted = !UncountedAllocations::active();
+  if (header->counted) {
+    allocations.count++;
+    allocations.bytes += size;
+    allocations.current += size;
+    if (allocations.current > allocations.peak) {
+      allocations.peak = allocations.current;
+    }
+  }
+  return header + 1;
+}
+
+void deallocate(void *ptr) {
+  if (ptr == nullptr) {
+    return;
+  }
+  Header *header = static_cast<Header *>(ptr) - 1;
+  if (header->counted) {
+    allocations.current -= header->size;
+  }
+  free(header);
+}
+
+}  // namespace
+
+void *operator new(size_t size) { return allocate(size); }
+void *operator new[](size_t size) { return allocate(size); }
+void operator delete(void *ptr) noexcept { deallocate(ptr); }
+void operator delete[](void *ptr) noexcept { deallocate(ptr); }
+void operator delete(void *ptr, size_t size) noexcept { deallocate(ptr); }
+void operator delete[](void *ptr, size_t size) noexcept { deallocate(ptr); }
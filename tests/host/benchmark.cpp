@@ -0,0 +1,428 @@
+// Benchmarks of the component on the host, printed as one JSON document to stdout.
+// Times on the simulated clock are reproducible; CPU times depend on the host.
+//   sim800l_benchmark [--quick]
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <string>
+
+#include "esphome/core/hal.h"
+
+#include "alloc_counter.h"
+#include "harness.h"
+#include "http_parser.h"
+#include "rx_buffer.h"
+#include "helpers.h"
+
+namespace esphome {
+namespace sim800l_data {
+namespace testing {
+namespace {
+
+const uint32_t BAUD_RATES[] = {9600, 19200, 38400, 57600, 115200, 230400, 460800};
+
+// Set when a benchmark did not get the expected result
+bool failed = false;
+
+// Thread CPU time in ns
+uint64_t cpu_ns() {
+  timespec time;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+  return time.tv_sec * 1000000000ULL + time.tv_nsec;
+}
+
+// Writes JSON without a trailing comma, one value per line.
+class JsonWriter {
+ public:
+  void begin_object(const char *key = nullptr) { this->begin_(key, '{'); }
+  void end_object() { this->end_('}'); }
+  void begin_array(const char *key = nullptr) { this->begin_(key, '['); }
+  void end_array() { this->end_(']'); }
+  void value(const char *key, double value) {
+    this->key_(key);
+    printf("%.4g", value);
+  }
+  void value(const char *key, uint64_t value) {
+    this->key_(key);
+    printf("%llu", static_cast<unsigned long long>(value));
+  }
+  void value(const char *key, const char *value) {
+    this->key_(key);
+    printf("\"%s\"", value);
+  }
+
+ protected:
+  void key_(const char *key) {
+    printf("%s\n%*s", this->first_ ? "" : ",", this->depth_ * 2, "");
+    this->first_ = false;
+    if (key != nullptr) {
+      printf("\"%s\": ", key);
+    }
+  }
+  void begin_(const char *key, char bracket) {
+    this->key_(key);
+    putchar(bracket);
+    this->depth_++;
+    this->first_ = true;
+  }
+  void end_(char bracket) {
+    this->depth_--;
+    printf("\n%*s%c", this->depth_ * 2, "", bracket);
+    this->first_ = false;
+  }
+
+  int depth_{0};
+  bool first_{true};
+};
+
+// A response body of length bytes
+std::string make_body(size_t length) {
+  std::string body;
+  body.reserve(length);
+  for (size_t i = 0; i < length; i++) {
+    body.push_back("0123456789abcdef"[i % 16]);
+  }
+  return body;
+}
+
+// Runs the harness and takes the CPU time and allocations of the component per state.
+// The emulator runs mostly before loop() is timed, so the CPU time is mainly that of the component.
+class MeasuredHarness : public Harness {
+ public:
+  using Harness::Harness;
+
+  void measured_step() {
+    this->modem.available();
+    const State state = this->component.state();
+    const uint64_t allocations_before = allocations.count;
+    const uint64_t start = cpu_ns();
+    this->component.loop();
+    const uint64_t duration = cpu_ns() - start;
+    this->cpu_ns_total += duration;
+    this->state_cpu_ns[static_cast<size_t>(state)] += duration;
+    this->state_allocations[static_cast<size_t>(state)] += allocations.count - allocations_before;
+    if (host::now_us() >= this->next_update_us_) {
+      this->component.update();
+      this->next_update_us_ += this->component.get_update_interval() * 1000ULL;
+    }
+    host::advance_us(this->step_us);
+  }
+
+  // Run one GET of the given URL to completion. Returns the status code, 0 if it failed.
+  uint16_t get(const char *url) {
+    uint16_t status = 0;
+    this->component.http_get(url, [this, &status](uint16_t status_code, std::string &body) {
+      status = status_code;
+      this->response_length = body.size();
+    });
+    const uint64_t end = host::now_us() + 120000000ULL;
+    do {
+      this->measured_step();
+    } while (!(this->component.state() == State::IDLE && this->component.get_http_queue_depth() == 0) &&
+             host::now_us() < end);
+    return status;
+  }
+
+  void reset_measurements() {
+    this->cpu_ns_total = 0;
+    memset(this->state_cpu_ns, 0, sizeof(this->state_cpu_ns));
+    memset(this->state_allocations, 0, sizeof(this->state_allocations));
+  }
+
+  // Length of the last response body
+  size_t response_length{0};
+  uint64_t cpu_ns_total{0};
+  uint64_t state_cpu_ns[STATE_COUNT]{};
+  uint64_t state_allocations[STATE_COUNT]{};
+};
+
+// RxBuffer as used by the RX path: blocks written at write_ptr(), lines taken out with find() and pop(),
+// data after a prompt taken out in chunks. The lines are appended to a reused string.
+void benchmark_rx_buffer(JsonWriter &json, uint32_t kilobytes) {
+  std::string input;
+  while (input.size() < 4096) {
+    input += "+HTTPACTION: 0,200,4096\r\n+CSQ: 17,0\r\nOK\r\n";
+  }
+  const size_t block_sizes[] = {16, 64, 256};
+
+  json.begin_array("rx_buffer");
+  for (size_t block_size : block_sizes) {
+    RxBuffer buffer;
+    std::string line;
+    std::string data;
+    // Reused strings keep their capacity, like the read buffers of the component
+    line.reserve(128);
+    data.reserve(RX_BUFFER_SIZE);
+    uint64_t bytes = 0;
+    uint64_t lines = 0;
+    size_t pos = 0;
+    const uint64_t allocations_before = allocations.count;
+    const uint64_t start = cpu_ns();
+    while (bytes < kilobytes * 1024ULL) {
+      size_t length = std::min({block_size, buffer.write_length(), input.size() - pos});
+      memcpy(buffer.write_ptr(), input.data() + pos, length);
+      buffer.commit(length);
+      pos = (pos + length) % input.size();
+      bytes += length;
+      // Every fourth block is read as data, the others line by line
+      if (bytes / block_size % 4 == 0) {
+        data.clear();
+        buffer.pop(data, buffer.size());
+        continue;
+      }
+      for (int end = buffer.find('\n'); end >= 0; end = buffer.find('\n')) {
+        line.clear();
+        buffer.pop(line, end);
+        buffer.drop(1);
+        lines++;
+      }
+    }
+    const uint64_t duration = cpu_ns() - start;
+    json.begin_object();
+    json.value("block_size", static_cast<uint64_t>(block_size));
+    json.value("bytes", bytes);
+    json.value("lines", lines);
+    json.value("bytes_per_us", static_cast<double>(bytes) * 1000 / duration);
+    json.value("allocations_per_kb", static_cast<double>(allocations.count - allocations_before) / kilobytes);
+    json.end_object();
+  }
+  json.end_array();
+}
+
+// HttpResponseParser, fed in blocks of 64 bytes like the socket reads of the keep-alive connection
+void benchmark_http_parser(JsonWriter &json, uint32_t iterations) {
+  const std::string body = make_body(4096);
+  const std::string chunk_header = "1000\r\n";
+  const std::string responses[] = {
+      "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nContent-Length: 4096\r\n\r\n" + body,
+      "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nTransfer-Encoding: chunked\r\n\r\n" + chunk_header + body +
+          "\r\n0\r\n\r\n",
+  };
+  const char *names[] = {"content_length", "chunked"};
+
+  json.begin_object("http_parser");
+  for (size_t i = 0; i < 2; i++) {
+    const std::string &response = responses[i];
+    HttpResponseParser parser;
+    uint64_t duration = 0;
+    uint64_t allocation_count = 0;
+    // The first response allocates the body, the others reuse it
+    for (uint32_t iteration = 0; iteration <= iterations; iteration++) {
+      const uint64_t allocations_before = allocations.count;
+      const uint64_t start = cpu_ns();
+      parser.reset();
+      for (size_t pos = 0; pos < response.size() && !parser.complete();) {
+        pos += parser.feed(response.data() + pos, std::min<size_t>(64, response.size() - pos));
+      }
+      if (iteration > 0) {
+        duration += cpu_ns() - start;
+        allocation_count += allocations.count - allocations_before;
+      }
+    }
+    if (!parser.complete() || parser.body() != body) {
+      failed = true;
+      fprintf(stderr, "http_parser %s: response not parsed\n", names[i]);
+    }
+    json.begin_object(names[i]);
+    json.value("response_bytes", static_cast<uint64_t>(response.size()));
+    json.value("cpu_ns_per_byte", static_cast<double>(duration) / (iterations * response.size()));
+    json.value("allocations_per_response", static_cast<double>(allocation_count) / iterations);
+    json.end_object();
+  }
+  json.end_object();
+}
+
+// ResponseTokenizer alone, on lines with quoted fields that contain commas and signed values
+void benchmark_tokenizer(JsonWriter &json, uint32_t iterations) {
+  const std::string_view lines[] = {
+      "+SAPBR: 1,1,\"10.0.0.1\"",
+      "+COPS: 0,0,\"Operator, Inc.\"",
+      "+CCLK: \"24/05/01,12:30:45+08\"",
+      "+CMTI: \"SM\",-1",
+      "+HTTPACTION: 0,200,4096",
+  };
+  uint64_t tokens = 0;
+  uint64_t bytes = 0;
+  uint64_t checksum = 0;
+  const uint64_t allocations_before = allocations.count;
+  const uint64_t start = cpu_ns();
+  for (uint32_t i = 0; i < iterations; i++) {
+    for (std::string_view line : lines) {
+      ResponseTokenizer tokenizer(line);
+      std::string_view param;
+      while (tokenizer.next(param)) {
+        checksum += param.size();
+        tokens++;
+      }
+      bytes += line.size();
+    }
+  }
+  const uint64_t duration = cpu_ns() - start;
+  // 3 + 3 + 1 + 2 + 3 tokens with 10 + 16 + 20 + 4 + 8 characters per iteration
+  if (tokens != 12ULL * iterations || checksum != 58ULL * iterations) {
+    failed = true;
+    fprintf(stderr, "tokenizer: wrong tokens\n");
+  }
+  json.begin_object("tokenizer");
+  json.value("cpu_ns_per_token", static_cast<double>(duration) / tokens);
+  json.value("cpu_ns_per_byte", static_cast<double>(duration) / bytes);
+  json.value("allocations", allocations.count - allocations_before);
+  json.end_object();
+}
+
+// parse_response() on the response lines of the periodic checks
+void benchmark_response_parser(JsonWriter &json, uint32_t iterations) {
+  const char *cbc = "+CBC: 0,75,3980";
+  const char *csq = "+CSQ: 17,0";
+  const char *httpaction = "+HTTPACTION: 0,200,4096";
+  uint64_t bytes = 0;
+  uint32_t failures = 0;
+  const uint64_t allocations_before = allocations.count;
+  const uint64_t start = cpu_ns();
+  for (uint32_t i = 0; i < iterations; i++) {
+    uint8_t charging, percent, rssi, ber, method;
+    uint16_t voltage, status;
+    uint32_t length;
+    failures += !parse_response(cbc, charging, percent, voltage);
+    failures += !parse_response(csq, rssi, ber);
+    failures += !parse_response(httpaction, method, status, length);
+    bytes += strlen(cbc) + strlen(csq) + strlen(httpaction);
+  }
+  const uint64_t duration = cpu_ns() - start;
+  if (failures > 0) {
+    failed = true;
+    fprintf(stderr, "response_parser: %u responses not parsed\n", failures);
+  }
+  json.begin_object("response_parser");
+  json.value("cpu_ns_per_response", static_cast<double>(duration) / (iterations * 3));
+  json.value("cpu_ns_per_byte", static_cast<double>(duration) / bytes);
+  json.value("allocations", allocations.count - allocations_before);
+  json.end_object();
+}
+
+// The RX path (loop() and handle_response_()) while receiving a GET response of 8 KB at each baud rate.
+// The CPU time per byte includes the loop() calls while waiting for data.
+// The body is streamed in chunks of the default size, as reading it at once takes longer than the
+// AT+HTTPREAD timeout at low rates.
+// Rates above 115200 can't be detected by autobaud, the module is set to them as if with AT+IPR before.
+void benchmark_rx_loop(JsonWriter &json, uint32_t transactions) {
+  json.begin_array("rx_loop");
+  for (uint32_t baud_rate : BAUD_RATES) {
+    MeasuredHarness h(baud_rate);
+    if (baud_rate > 115200) {
+      h.modem.config.fixed_baud_rate = baud_rate;
+      // The module sends RDY when it started at a fixed rate
+      h.modem.config.boot_time = 1000;
+    }
+    const std::string body = make_body(8192);
+    h.modem.http_handler = [&body](const std::string &method, const std::string &url, const std::string &data) {
+      return Sim800lEmulator::HttpResponse{200, body};
+    };
+    uint64_t streamed = 0;
+    h.component.set_stream_response(true);
+    h.component.add_on_http_response_chunk_callback(
+        [&streamed](uint32_t offset, std::string &chunk) { streamed += chunk.size(); });
+    h.setup();
+    if (!h.boot()) {
+      failed = true;
+      fprintf(stderr, "rx_loop %u: boot failed\n", baud_rate);
+      continue;
+    }
+    h.reset_measurements();
+    const uint64_t bytes_before = h.modem.get_bytes_sent();
+    const uint64_t start_us = host::now_us();
+    uint32_t failures = 0;
+    for (uint32_t i = 0; i < transactions; i++) {
+      failures += h.get("http://example.com/large") != 200;
+    }
+    failures += streamed != transactions * body.size();
+    const uint64_t bytes = h.modem.get_bytes_sent() - bytes_before;
+    json.begin_object();
+    json.value("baud_rate", static_cast<uint64_t>(baud_rate));
+    json.value("rx_bytes", bytes);
+    json.value("cpu_ns_per_byte", static_cast<double>(h.cpu_ns_total) / bytes);
+    json.value("simulated_ms_per_transaction", static_cast<double>(host::now_us() - start_us) / 1000 / transactions);
+    json.value("rx_overrun_bytes", static_cast<uint64_t>(h.modem.get_overrun_bytes()));
+    json.value("failed_transactions", static_cast<uint64_t>(failures));
+    json.end_object();
+  }
+  json.end_array();
+}
+
+// Full GET from HTTP_INIT to HTTP_CLOSE_BEARER at 115200 baud, after one warm-up transaction
+void benchmark_http_get(JsonWriter &json, uint32_t transactions) {
+  MeasuredHarness h(115200);
+  const std::string body = make_body(1024);
+  h.modem.http_handler = [&body](const std::string &method, const std::string &url, const std::string &data) {
+    return Sim800lEmulator::HttpResponse{200, body};
+  };
+  h.setup();
+  if (!h.boot() || h.get("http://example.com/warm-up") != 200 || h.response_length != body.size()) {
+    failed = true;
+    fprintf(stderr, "http_get: warm-up failed\n");
+    return;
+  }
+  uint32_t state_ms_before[STATE_COUNT];
+  for (size_t i = 0; i < STATE_COUNT; i++) {
+    state_ms_before[i] = h.component.time_in_state(static_cast<State>(i));
+  }
+  h.reset_measurements();
+  const uint64_t allocations_before = allocations.count;
+  const uint64_t bytes_before = allocations.bytes;
+  const int64_t heap_before = allocations.current;
+  allocations.reset_peak();
+  const uint64_t start_us = host::now_us();
+  uint32_t failures = 0;
+  for (uint32_t i = 0; i < transactions; i++) {
+    failures += h.get("http://example.com/a") != 200 || h.response_length != body.size();
+  }
+
+  json.begin_object("http_get");
+  json.value("transactions", static_cast<uint64_t>(transactions));
+  json.value("failed_transactions", static_cast<uint64_t>(failures));
+  json.value("response_bytes", static_cast<uint64_t>(body.size()));
+  json.value("cpu_us_per_transaction", static_cast<double>(h.cpu_ns_total) / 1000 / transactions);
+  json.value("simulated_ms_per_transaction", static_cast<double>(host::now_us() - start_us) / 1000 / transactions);
+  json.value("allocations_per_transaction", static_cast<double>(allocations.count - allocations_before) / transactions);
+  json.value("allocated_bytes_per_transaction",
+             static_cast<double>(allocations.bytes - bytes_before) / transactions);
+  json.value("peak_heap_bytes", static_cast<uint64_t>(allocations.peak - heap_before));
+  json.begin_object("states");
+  for (size_t i = 0; i < STATE_COUNT; i++) {
+    const uint32_t state_ms = h.component.time_in_state(static_cast<State>(i)) - state_ms_before[i];
+    if (state_ms == 0 && h.state_cpu_ns[i] == 0) {
+      continue;
+    }
+    json.begin_object(state_to_string(static_cast<State>(i)));
+    json.value("simulated_ms", static_cast<double>(state_ms) / transactions);
+    json.value("cpu_us", static_cast<double>(h.state_cpu_ns[i]) / 1000 / transactions);
+    json.value("allocations", static_cast<double>(h.state_allocations[i]) / transactions);
+    json.end_object();
+  }
+  json.end_object();
+  json.end_object();
+}
+
+}  // namespace
+}  // namespace testing
+}  // namespace sim800l_data
+}  // namespace esphome
+
+int main(int argc, char **argv) {
+  using namespace esphome::sim800l_data::testing;
+  // The quick run only checks that the benchmarks work
+  const bool quick = argc > 1 && strcmp(argv[1], "--quick") == 0;
+  JsonWriter json;
+  json.begin_object();
+  json.value("mode", quick ? "quick" : "full");
+  benchmark_rx_buffer(json, quick ? 16 : 65536);
+  benchmark_http_parser(json, quick ? 10 : 2000);
+  benchmark_tokenizer(json, quick ? 100 : 200000);
+  benchmark_response_parser(json, quick ? 100 : 200000);
+  benchmark_rx_loop(json, quick ? 1 : 3);
+  benchmark_http_get(json, quick ? 2 : 20);
+  json.end_object();
+  putchar('\n');
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,69 @@
+#include "harness.h"
+
+#include "esphome/core/hal.h"
+#include "esphome/core/log.h"
+#include "esphome/core/preferences.h"
+
+namespace esphome {
+namespace sim800l_data {
+namespace testing {
+
+Harness::Harness(uint32_t baud_rate, bool keep_preferences) {
+  host::set_now_us(0);
+  host::reset_log_counts();
+  if (!keep_preferences) {
+    global_preferences->clear();
+  }
+  this->modem.set_baud_rate(baud_rate);
+  this->component.set_uart_parent(&this->modem);
+  this->component.set_update_interval(60000);
+  this->component.set_apn("internet");
+}
+
+void Harness::setup() {
+  this->modem.power_on();
+  this->component.setup();
+  this->next_update_us_ = host::now_us() + this->component.get_update_interval() * 1000ULL;
+}
+
+void Harness::step() {
+  this->component.loop();
+  if (host::now_us() >= this->next_update_us_) {
+    this->component.update();
+    this->next_update_us_ += this->component.get_update_interval() * 1000ULL;
+  }
+  host::advance_us(this->step_us);
+}
+
+void Harness::run_for(uint32_t ms) {
+  const uint64_t end = host::now_us() + ms * 1000ULL;
+  while (host::now_us() < end) {
+    this->step();
+  }
+}
+
+bool Harness::run_until(const std::function<bool()> &done, uint32_t timeout) {
+  const uint64_t end = host::now_us() + timeout * 1000ULL;
+  while (!done()) {
+    if (host::now_us() >= end) {
+      return false;
+    }
+    this->step();
+  }
+  return true;
+}
+
+bool Harness::boot(uint32_t timeout) {
+  return this->run_until([this]() { return this->component.initialized() && this->component.state() == State::IDLE; },
+                         timeout);
+}
+
+bool Harness::run_until_idle(uint32_t timeout) {
+  return this->run_until(
+      [this]() { return this->component.state() == State::IDLE && this->component.get_http_queue_depth() == 0; },
+      timeout);
+}
+
+}  // namespace testing
+}  // namespace sim800l_data
+}  // namespace esphome
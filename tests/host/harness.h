@@ -0,0 +1,87 @@
+#pragma once
+
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "sim800l_data.h"
+#include "sim800l_emulator.h"
+
+namespace esphome {
+namespace sim800l_data {
+
+// Print states by name in failed checks.
+inline std::ostream &operator<<(std::ostream &out, State state) { return out << state_to_string(state); }
+
+namespace testing {
+
+// Gives tests access to the state of the component.
+class TestComponent : public Sim800LDataComponent {
+ public:
+  State state() const { return this->state_; }
+  bool initialized() const { return this->initialized_; }
+  bool registered() const { return this->registered_; }
+  bool idle_sleep_active() const { return this->idle_sleep_active_; }
+  bool socket_keep_alive() const { return this->socket_keep_alive_; }
+  uint32_t time_in_state(State state) const {
+    return this->state_latency_[static_cast<size_t>(state)].total;
+  }
+  const TimeoutEstimates &timeout_estimates() const { return this->timeout_estimates_; }
+  const CommandStats &command_stats(CommandId id) const { return this->command_stats_[static_cast<size_t>(id)]; }
+};
+
+// GPIO that records its level and drives DTR of the emulator.
+class MockPin : public GPIOPin {
+ public:
+  explicit MockPin(Sim800lEmulator *modem) : modem_(modem) {}
+  void setup() override { this->is_setup = true; }
+  void digital_write(bool value) override {
+    this->level = value;
+    this->writes.push_back(value);
+    this->modem_->set_dtr(value);
+  }
+  bool digital_read() override { return this->level; }
+
+  bool is_setup{false};
+  bool level{false};
+  std::vector<bool> writes;
+
+ protected:
+  Sim800lEmulator *modem_;
+};
+
+// Runs the component against the emulator on the host clock, like the ESPHome main loop:
+// loop() every step, update() every update interval.
+class Harness {
+ public:
+  // Resets the clock and the preferences, unless keep_preferences is set to simulate a reboot.
+  explicit Harness(uint32_t baud_rate = 9600, bool keep_preferences = false);
+
+  // Power on the module and set up the component.
+  void setup();
+  // Run one iteration of the main loop and advance the clock by one step.
+  void step();
+  void run_for(uint32_t ms);
+  // Run until done returns true. Returns false if it did not within timeout ms.
+  bool run_until(const std::function<bool()> &done, uint32_t timeout);
+  bool run_until_state(State state, uint32_t timeout) {
+    return this->run_until([this, state]() { return this->component.state() == state; }, timeout);
+  }
+  // Run until the component is initialized and idle.
+  bool boot(uint32_t timeout = 60000);
+  // Run until the component is idle with no queued HTTP request.
+  bool run_until_idle(uint32_t timeout);
+
+  Sim800lEmulator modem;
+  TestComponent component;
+  // Time between two loop() calls in us.
+  uint32_t step_us{1000};
+
+ protected:
+  uint64_t next_update_us_{0};
+};
+
+}  // namespace testing
+}  // namespace sim800l_data
+}  // namespace esphome
@@ -0,0 +1,633 @@
+#include "sim800l_emulator.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+#include "esphome/core/hal.h"
+
+#include "alloc_counter.h"
+
+namespace esphome {
+namespace sim800l_data {
+namespace testing {
+
+// The module detects the baud rate from the first AT up to this rate
+static const uint32_t MAX_AUTOBAUD_RATE = 115200;
+// The serial port is usable this long after DTR was pulled low
+static const uint32_t DTR_WAKE_TIME = 50;
+// Delay of the URCs after the SIM was unlocked
+static const uint32_t SIM_UNLOCK_TIME = 200;
+
+static bool starts_with(const std::string &text, const std::string &prefix) {
+  return text.compare(0, prefix.size(), prefix) == 0;
+}
+
+// Returns the text between the first pair of quotes after offset, or the rest of the text if it is not quoted.
+static std::string unquote(const std::string &text, size_t offset = 0) {
+  const size_t start = text.find('"', offset);
+  if (start == std::string::npos) {
+    return text.substr(offset);
+  }
+  const size_t end = text.find('"', start + 1);
+  return text.substr(start + 1, end == std::string::npos ? std::string::npos : end - start - 1);
+}
+
+Sim800lEmulator::Sim800lEmulator() {
+  this->http_handler = [](const std::string &method, const std::string &url, const std::string &body) {
+    return HttpResponse{200, "OK"};
+  };
+}
+
+void Sim800lEmulator::power_on() {
+  this->events_.clear();
+  this->wire_.clear();
+  this->wire_free_ns_ = 0;
+  this->fifo_.clear();
+  this->commands_.clear();
+  this->line_.clear();
+  this->data_remaining_ = 0;
+
+  const uint64_t now = this->now_();
+  this->boot_at_us_ = now + this->config.boot_time * 1000ULL;
+  this->last_input_us_ = now;
+  this->detected_baud_rate_ = 0;
+  if (!this->config.keep_baud_rate || this->ipr_ == 0) {
+    this->ipr_ = this->config.fixed_baud_rate;
+  }
+  this->echo_ = true;
+  this->csclk_ = 0;
+  this->sim_ready_ = false;
+  this->pin_locked_ = !this->config.pin.empty();
+  this->creg_urc_ = false;
+  this->registration_ = 2;
+  this->registration_due_ = false;
+  this->bearer_open_ = false;
+  this->http_initialized_ = false;
+  this->http_has_response_ = false;
+  this->ip_started_ = false;
+  this->socket_connected_ = false;
+  this->socket_rx_.clear();
+
+  // With a fixed baud rate the module reports that it has started
+  this->schedule_(this->config.boot_time, [this]() {
+    if (this->ipr_ > 0) {
+      this->emit_line_("RDY", 0);
+    }
+  });
+  this->schedule_(std::max(this->config.sim_ready_time, this->config.boot_time), [this]() {
+    this->sim_ready_ = true;
+    if (this->pin_locked_) {
+      this->emit_line_("+CPIN: SIM PIN", 0);
+      return;
+    }
+    this->emit_line_("+CPIN: READY", 0);
+    this->emit_line_("Call Ready", 0);
+    this->emit_line_("SMS Ready", 0);
+  });
+  this->schedule_(std::max(this->config.registration_time, this->config.boot_time), [this]() {
+    this->registration_due_ = true;
+    this->update_registration_();
+  });
+}
+
+void Sim800lEmulator::update_registration_() {
+  if (this->registration_due_ && this->sim_ready_ && !this->pin_locked_ && this->registration_ == 2) {
+    this->set_registration(1);
+  }
+}
+
+void Sim800lEmulator::set_latency(const std::string &prefix, uint32_t latency) { this->latencies_[prefix] = latency; }
+
+void Sim800lEmulator::fail_next(const std::string &prefix, uint32_t count) { this->errors_[prefix] += count; }
+
+void Sim800lEmulator::drop_next(const std::string &prefix, uint32_t count) { this->drops_[prefix] += count; }
+
+void Sim800lEmulator::send_urc(const std::string &line, uint32_t delay) { this->emit_line_(line, delay); }
+
+void Sim800lEmulator::set_registration(uint8_t stat, uint32_t delay, bool urc) {
+  this->schedule_(delay, [this, stat, urc]() {
+    this->registration_ = stat;
+    if (this->creg_urc_ && urc) {
+      this->emit_line_("+CREG: " + std::to_string(stat), 0);
+    }
+  });
+}
+
+void Sim800lEmulator::socket_server_send(const std::string &data, uint32_t delay) {
+  this->schedule_(delay, [this, data]() { this->socket_received_(data); });
+}
+
+void Sim800lEmulator::socket_server_close(uint32_t delay) {
+  this->schedule_(delay, [this]() {
+    if (this->socket_connected_) {
+      this->socket_connected_ = false;
+      this->emit_line_("CLOSED", 0);
+    }
+  });
+}
+
+void Sim800lEmulator::set_dtr(bool high) {
+  const UncountedAllocations uncounted;
+  if (this->dtr_high_ && !high) {
+    this->dtr_low_at_us_ = this->now_();
+  }
+  this->dtr_high_ = high;
+}
+
+size_t Sim800lEmulator::count(const std::string &prefix) const {
+  return std::count_if(this->commands_.begin(), this->commands_.end(),
+                       [&prefix](const std::string &command) { return starts_with(command, prefix); });
+}
+
+uint32_t Sim800lEmulator::module_baud_rate() const {
+  return this->ipr_ > 0 ? this->ipr_ : this->detected_baud_rate_;
+}
+
+bool Sim800lEmulator::is_asleep() const {
+  const uint64_t now = this->now_();
+  if (this->csclk_ == 1) {
+    return this->dtr_high_ || now - this->dtr_low_at_us_ < DTR_WAKE_TIME * 1000ULL;
+  }
+  return this->csclk_ == 2 && now - this->last_input_us_ >= this->config.auto_sleep_time * 1000ULL;
+}
+
+uint64_t Sim800lEmulator::next_event_us() const {
+  uint64_t next = std::numeric_limits<uint64_t>::max();
+  for (const Event &event : this->events_) {
+    next = std::min(next, event.at_us);
+  }
+  if (!this->wire_.empty()) {
+    next = std::min(next, (this->wire_.front().at_ns + 999) / 1000);
+  }
+  return next;
+}
+
+uint64_t Sim800lEmulator::now_() const { return this->in_event_ ? this->event_us_ : host::now_us(); }
+
+void Sim800lEmulator::schedule_(uint32_t delay, std::function<void()> action) {
+  this->events_.push_back({this->now_() + delay * 1000ULL, this->event_order_++, std::move(action)});
+}
+
+void Sim800lEmulator::emit_(const std::string &text, uint32_t delay) {
+  this->schedule_(delay, [this, text]() {
+    const uint32_t baud_rate = this->module_baud_rate();
+    if (baud_rate == 0) {
+      // Nothing can be sent before the baud rate is known
+      this->garbled_bytes_ += text.size();
+      return;
+    }
+    // 8N1: start bit, 8 data bits and stop bit
+    const uint64_t byte_ns = 10000000000ULL / baud_rate;
+    uint64_t at_ns = std::max(this->now_() * 1000, this->wire_free_ns_);
+    for (char c : text) {
+      at_ns += byte_ns;
+      this->wire_.push_back({at_ns, baud_rate, static_cast<uint8_t>(c)});
+    }
+    this->wire_free_ns_ = at_ns;
+    this->bytes_sent_ += text.size();
+  });
+}
+
+void Sim800lEmulator::update_() {
+  const uint64_t now = host::now_us();
+  while (true) {
+    // Run the earliest due event; events can schedule new ones
+    auto next = this->events_.end();
+    for (auto it = this->events_.begin(); it != this->events_.end(); ++it) {
+      if (it->at_us <= now &&
+          (next == this->events_.end() || it->at_us < next->at_us ||
+           (it->at_us == next->at_us && it->order < next->order))) {
+        next = it;
+      }
+    }
+    if (next == this->events_.end()) {
+      break;
+    }
+    Event event = std::move(*next);
+    this->events_.erase(next);
+    this->in_event_ = true;
+    this->event_us_ = event.at_us;
+    event.action();
+    this->in_event_ = false;
+  }
+
+  while (!this->wire_.empty() && this->wire_.front().at_ns <= now * 1000) {
+    const WireByte &byte = this->wire_.front();
+    if (byte.baud_rate != this->baud_rate_) {
+      this->garbled_bytes_++;
+    } else if (this->fifo_.size() >= this->rx_buffer_size_) {
+      this->overrun_bytes_++;
+    } else {
+      this->fifo_.push_back(byte.data);
+    }
+    this->wire_.pop_front();
+  }
+}
+
+int Sim800lEmulator::available() {
+  const UncountedAllocations uncounted;
+  this->update_();
+  return this->fifo_.size();
+}
+
+bool Sim800lEmulator::read_array(uint8_t *data, size_t len) {
+  const UncountedAllocations uncounted;
+  this->update_();
+  if (this->fifo_.size() < len) {
+    return false;
+  }
+  std::copy_n(this->fifo_.begin(), len, data);
+  this->fifo_.erase(this->fifo_.begin(), this->fifo_.begin() + len);
+  return true;
+}
+
+void Sim800lEmulator::write_array(const uint8_t *data, size_t len) {
+  const UncountedAllocations uncounted;
+  this->update_();
+  for (size_t i = 0; i < len; i++) {
+    const char c = static_cast<char>(data[i]);
+    // The line feed after a command is ignored, also when the command starts data input
+    const bool after_command = this->after_command_;
+    this->after_command_ = false;
+    if (c == '\n' && after_command) {
+      continue;
+    }
+    if (this->data_remaining_ > 0) {
+      this->data_.push_back(c);
+      if (--this->data_remaining_ == 0) {
+        this->handle_data_(this->data_);
+      }
+    } else if (c == '\r') {
+      const std::string line = std::move(this->line_);
+      this->line_.clear();
+      if (this->accepts_input_(line)) {
+        this->handle_line_(line);
+      }
+      this->after_command_ = true;
+      this->last_input_us_ = host::now_us();
+    } else if (c != '\n') {
+      this->line_.push_back(c);
+    }
+  }
+}
+
+bool Sim800lEmulator::accepts_input_(const std::string &line) {
+  if (host::now_us() < this->boot_at_us_) {
+    return false;
+  }
+  if (this->is_asleep()) {
+    // With AT+CSCLK=2 the first characters wake the module, but are lost
+    return false;
+  }
+  if (this->module_baud_rate() == 0) {
+    if (this->baud_rate_ > MAX_AUTOBAUD_RATE || line.size() < 2 || toupper(line[0]) != 'A' ||
+        toupper(line[1]) != 'T') {
+      return false;
+    }
+    this->detected_baud_rate_ = this->baud_rate_;
+  }
+  if (this->module_baud_rate() != this->baud_rate_) {
+    this->garbled_bytes_ += line.size() + 1;
+    return false;
+  }
+  return true;
+}
+
+uint32_t Sim800lEmulator::latency_of_(const std::string &command, uint32_t latency) const {
+  // The longest matching prefix wins
+  size_t matched = 0;
+  for (const auto &entry : this->latencies_) {
+    if (starts_with(command, entry.first) && entry.first.size() >= matched) {
+      matched = entry.first.size();
+      latency = entry.second;
+    }
+  }
+  return latency;
+}
+
+bool Sim800lEmulator::take_fault_(std::map<std::string, uint32_t> &faults, const std::string &command) {
+  for (auto &entry : faults) {
+    const bool matches = entry.first.empty() ? command.empty() : starts_with(command, entry.first);
+    if (matches && entry.second > 0) {
+      entry.second--;
+      return true;
+    }
+  }
+  return false;
+}
+
+void Sim800lEmulator::handle_line_(const std::string &line) {
+  if (line.size() < 2 || toupper(line[0]) != 'A' || toupper(line[1]) != 'T') {
+    return;
+  }
+  if (this->echo_) {
+    this->emit_(line + "\r\n", 0);
+  }
+
+  // Split combined commands like AT+CBC;+CSQ, but not at semicolons in quotes
+  std::vector<std::string> parts;
+  std::string part;
+  bool quoted = false;
+  for (size_t i = 2; i < line.size(); i++) {
+    if (line[i] == '"') {
+      quoted = !quoted;
+    }
+    if (line[i] == ';' && !quoted) {
+      parts.push_back(std::move(part));
+      part.clear();
+    } else {
+      part.push_back(line[i]);
+    }
+  }
+  parts.push_back(std::move(part));
+
+  Reply reply{"", "OK", 0};
+  for (const std::string &command : parts) {
+    this->commands_.push_back(command);
+    if (this->take_fault_(this->drops_, command)) {
+      return;
+    }
+    Reply command_reply{"", "OK", this->latency_of_(command, this->config.command_latency)};
+    if (this->take_fault_(this->errors_, command)) {
+      command_reply.result = "ERROR";
+    } else {
+      this->handle_command_(command, command_reply);
+    }
+    reply.lines += command_reply.lines;
+    reply.latency = std::max(reply.latency, command_reply.latency);
+    if (command_reply.result != "OK") {
+      reply.result = command_reply.result;
+      break;
+    }
+  }
+  if (!reply.result.empty()) {
+    reply.lines += "\r\n" + reply.result + "\r\n";
+  }
+  if (!reply.lines.empty()) {
+    this->emit_(reply.lines, reply.latency);
+  }
+}
+
+void Sim800lEmulator::handle_command_(const std::string &command, Reply &reply) {
+  auto line = [&reply](const std::string &text) { reply.lines += "\r\n" + text + "\r\n"; };
+  auto arg = [&command](const char *prefix) { return command.substr(strlen(prefix)); };
+  const bool registered = this->registration_ == 1 || this->registration_ == 5;
+
+  if (command.empty() || command == "+IFC=2,2" || starts_with(command, "+SAPBR=3,1,") ||
+      starts_with(command, "+CSTT=")) {
+    return;
+  }
+  if (command == "E0" || command == "E1") {
+    this->echo_ = command == "E1";
+    return;
+  }
+  if (starts_with(command, "+IPR=")) {
+    // Answered at the old rate, then the module switches. The reply is sent after the events scheduled here.
+    const uint32_t baud_rate = strtoul(arg("+IPR=").c_str(), nullptr, 10);
+    this->schedule_(reply.latency + 1, [this, baud_rate]() { this->ipr_ = baud_rate; });
+    return;
+  }
+  if (starts_with(command, "+CSCLK=")) {
+    this->csclk_ = atoi(arg("+CSCLK=").c_str());
+    return;
+  }
+  if (command == "+CBC") {
+    line("+CBC: 0," + std::to_string(this->config.battery_percent) + "," +
+         std::to_string(this->config.battery_voltage));
+    return;
+  }
+  if (command == "+CSQ") {
+    line("+CSQ: " + std::to_string(this->config.rssi) + ",0");
+    return;
+  }
+  if (command == "+CPIN?") {
+    line(!this->sim_ready_ ? "+CPIN: NOT READY" : this->pin_locked_ ? "+CPIN: SIM PIN" : "+CPIN: READY");
+    return;
+  }
+  if (starts_with(command, "+CPIN=")) {
+    if (!this->pin_locked_ || unquote(command) != this->config.pin) {
+      reply.result = "ERROR";
+      return;
+    }
+    this->pin_locked_ = false;
+    this->schedule_(reply.latency + SIM_UNLOCK_TIME, [this]() {
+      this->emit_line_("+CPIN: READY", 0);
+      this->emit_line_("Call Ready", 0);
+      this->emit_line_("SMS Ready", 0);
+      this->update_registration_();
+    });
+    return;
+  }
+  if (command == "+CREG=1") {
+    this->creg_urc_ = true;
+    return;
+  }
+  if (command == "+CREG?") {
+    line("+CREG: " + std::string(this->creg_urc_ ? "1," : "0,") + std::to_string(this->registration_));
+    return;
+  }
+  if (command == "+SAPBR=2,1") {
+    line(this->bearer_open_ ? "+SAPBR: 1,1,\"10.0.0.1\"" : "+SAPBR: 1,3,\"0.0.0.0\"");
+    return;
+  }
+  if (command == "+SAPBR=1,1") {
+    reply.latency = this->latency_of_(command, this->config.bearer_open_latency);
+    if (this->bearer_open_ || !registered) {
+      reply.result = "ERROR";
+      return;
+    }
+    this->bearer_open_ = true;
+    return;
+  }
+  if (command == "+SAPBR=0,1") {
+    if (!this->bearer_open_) {
+      reply.result = "ERROR";
+      return;
+    }
+    this->bearer_open_ = false;
+    return;
+  }
+  if (command == "+HTTPINIT") {
+    if (this->http_initialized_) {
+      reply.result = "ERROR";
+      return;
+    }
+    this->http_initialized_ = true;
+    this->http_has_response_ = false;
+    this->http_data_.clear();
+    return;
+  }
+  if (starts_with(command, "+HTTP") && !this->http_initialized_) {
+    reply.result = "ERROR";
+    return;
+  }
+  if (command == "+HTTPTERM") {
+    this->http_initialized_ = false;
+    return;
+  }
+  if (starts_with(command, "+HTTPPARA=\"URL\",")) {
+    this->http_url_ = unquote(command, strlen("+HTTPPARA=\"URL\","));
+    return;
+  }
+  if (starts_with(command, "+HTTPPARA=") || starts_with(command, "+HTTPSSL=")) {
+    return;
+  }
+  if (starts_with(command, "+HTTPDATA=")) {
+    const uint32_t size = strtoul(arg("+HTTPDATA=").c_str(), nullptr, 10);
+    this->http_data_.clear();
+    if (size == 0) {
+      return;
+    }
+    line("DOWNLOAD");
+    reply.result.clear();
+    this->data_command_ = "+HTTPDATA";
+    this->data_.clear();
+    this->data_remaining_ = size;
+    return;
+  }
+  if (starts_with(command, "+HTTPACTION=")) {
+    const int method = atoi(arg("+HTTPACTION=").c_str());
+    HttpResponse response{601, ""};
+    if (this->bearer_open_) {
+      response = this->http_handler(method == 1 ? "POST" : "GET", this->http_url_, this->http_data_);
+    }
+    const uint32_t delay = reply.latency + this->latency_of_("+HTTPACTION:", this->config.http_action_latency);
+    this->schedule_(delay, [this, method, response]() {
+      this->http_response_ = response.body;
+      this->http_has_response_ = true;
+      this->emit_line_("+HTTPACTION: " + std::to_string(method) + "," + std::to_string(response.status) + "," +
+                           std::to_string(response.body.size()),
+                       0);
+    });
+    return;
+  }
+  if (starts_with(command, "+HTTPREAD")) {
+    if (!this->http_has_response_) {
+      reply.result = "ERROR";
+      return;
+    }
+    std::string body = this->http_response_;
+    if (starts_with(command, "+HTTPREAD=")) {
+      uint32_t offset = 0, length = 0;
+      sscanf(command.c_str(), "+HTTPREAD=%u,%u", &offset, &length);
+      body = offset < body.size() ? body.substr(offset, length) : "";
+    }
+    reply.lines += "\r\n+HTTPREAD: " + std::to_string(body.size()) + "\r\n" + body;
+    return;
+  }
+  if (command == "+CIPSHUT") {
+    this->ip_started_ = false;
+    this->socket_connected_ = false;
+    this->socket_rx_.clear();
+    reply.result = "SHUT OK";
+    return;
+  }
+  if (command == "+CIPRXGET=1") {
+    return;
+  }
+  if (command == "+CIICR") {
+    reply.latency = this->latency_of_(command, this->config.bearer_open_latency);
+    if (this->ip_started_ || !registered) {
+      reply.result = "ERROR";
+      return;
+    }
+    this->ip_started_ = true;
+    return;
+  }
+  if (command == "+CIFSREX") {
+    if (!this->ip_started_) {
+      reply.result = "ERROR";
+      return;
+    }
+    line("+CIFSREX: 10.0.0.2");
+    return;
+  }
+  if (starts_with(command, "+CIPSTART=")) {
+    if (!this->ip_started_ || this->socket_connected_) {
+      reply.result = "ERROR";
+      return;
+    }
+    const uint32_t delay = reply.latency + this->latency_of_("CONNECT", this->config.socket_connect_latency);
+    this->schedule_(delay, [this]() {
+      if (this->config.refuse_connections) {
+        this->emit_line_("CONNECT FAIL", 0);
+        return;
+      }
+      this->socket_connected_ = true;
+      this->emit_line_("CONNECT OK", 0);
+    });
+    return;
+  }
+  if (starts_with(command, "+CIPSEND=")) {
+    const uint32_t size = strtoul(arg("+CIPSEND=").c_str(), nullptr, 10);
+    if (!this->socket_connected_ || size == 0) {
+      reply.result = "ERROR";
+      return;
+    }
+    reply.lines += "\r\n> ";
+    reply.result.clear();
+    this->data_command_ = "+CIPSEND";
+    this->data_.clear();
+    this->data_remaining_ = size;
+    return;
+  }
+  if (starts_with(command, "+CIPRXGET=2,")) {
+    if (!this->socket_connected_ && this->socket_rx_.empty()) {
+      reply.result = "ERROR";
+      return;
+    }
+    const size_t length = std::min<size_t>(strtoul(arg("+CIPRXGET=2,").c_str(), nullptr, 10), this->socket_rx_.size());
+    const std::string data = this->socket_rx_.substr(0, length);
+    this->socket_rx_.erase(0, length);
+    reply.lines += "\r\n+CIPRXGET: 2," + std::to_string(length) + "," + std::to_string(this->socket_rx_.size()) +
+                   "\r\n" + data;
+    return;
+  }
+  if (command == "+CIPCLOSE") {
+    if (!this->socket_connected_) {
+      reply.result = "ERROR";
+      return;
+    }
+    this->socket_connected_ = false;
+    this->socket_rx_.clear();
+    reply.result = "CLOSE OK";
+    return;
+  }
+  reply.result = "ERROR";
+}
+
+void Sim800lEmulator::handle_data_(const std::string &data) {
+  const uint32_t latency = this->latency_of_(this->data_command_, this->config.command_latency);
+  if (this->data_command_ == "+HTTPDATA") {
+    this->http_data_ = data;
+    this->emit_line_("OK", latency);
+    return;
+  }
+  this->emit_line_("SEND OK", latency);
+  if (this->socket_handler) {
+    const std::string response = this->socket_handler(data);
+    if (!response.empty()) {
+      this->socket_server_send(response, latency + this->config.network_latency);
+    }
+  }
+}
+
+void Sim800lEmulator::socket_received_(const std::string &data) {
+  if (!this->socket_connected_) {
+    return;
+  }
+  // Received data is announced once, until all of it was fetched
+  const bool announce = this->socket_rx_.empty();
+  this->socket_rx_ += data;
+  if (announce) {
+    this->emit_line_("+CIPRXGET: 1", 0);
+  }
+}
+
+}  // namespace testing
+}  // namespace sim800l_data
+}  // namespace esphome
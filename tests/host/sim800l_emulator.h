@@ -0,0 +1,196 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "esphome/components/uart/uart.h"
+
+namespace esphome {
+namespace sim800l_data {
+namespace testing {
+
+// Scriptable SIM800L on the other end of the UART. It answers the AT commands the component uses
+// with the timing of the configured baud rate, and can inject latency, errors, lost responses and URCs.
+// Time is taken from the host clock, so it only moves when the harness advances it.
+class Sim800lEmulator : public uart::UARTComponent {
+ public:
+  struct HttpResponse {
+    uint16_t status;
+    std::string body;
+  };
+  // Called for each +HTTPACTION with the method (GET or POST), URL and posted body.
+  using HttpHandler = std::function<HttpResponse(const std::string &method, const std::string &url,
+                                                 const std::string &body)>;
+  // Called with each block written to the socket. Returns the data the server sends back.
+  using SocketHandler = std::function<std::string(const std::string &data)>;
+
+  struct Config {
+    // Delays in ms, measured from power on
+    uint32_t boot_time{0};
+    uint32_t sim_ready_time{0};
+    uint32_t registration_time{0};
+    // SIM PIN, the SIM is locked until it is entered. Empty if the SIM is not locked.
+    std::string pin;
+    // Fixed baud rate of the module, as if set with AT+IPR before. 0 detects the rate from the first AT.
+    uint32_t fixed_baud_rate{0};
+    // Whether a rate set with AT+IPR is kept when the module restarts.
+    bool keep_baud_rate{false};
+    // The module sleeps after the serial port was idle this long with AT+CSCLK=2.
+    uint32_t auto_sleep_time{5000};
+    // Default latency of a command and of the slower operations
+    uint32_t command_latency{10};
+    uint32_t bearer_open_latency{1500};
+    uint32_t http_action_latency{800};
+    uint32_t socket_connect_latency{500};
+    uint32_t network_latency{100};
+    uint8_t battery_percent{75};
+    uint16_t battery_voltage{3980};
+    uint8_t rssi{17};
+    // Fail AT+CIPSTART with CONNECT FAIL
+    bool refuse_connections{false};
+  };
+
+  Sim800lEmulator();
+
+  // UARTComponent
+  void write_array(const uint8_t *data, size_t len) override;
+  bool read_array(uint8_t *data, size_t len) override;
+  int available() override;
+  void flush() override {}
+
+  Config config;
+  HttpHandler http_handler;
+  SocketHandler socket_handler;
+
+  // Power cycle the module. The config is applied from here on.
+  void power_on();
+
+  // Latency of commands starting with prefix (after AT, e.g. "+CBC"). Overrides the default latency.
+  void set_latency(const std::string &prefix, uint32_t latency);
+  // Answer the next count commands starting with prefix with ERROR.
+  void fail_next(const std::string &prefix, uint32_t count = 1);
+  // Do not answer the next count commands starting with prefix at all.
+  void drop_next(const std::string &prefix, uint32_t count = 1);
+  // Send an unsolicited line after delay ms.
+  void send_urc(const std::string &line, uint32_t delay = 0);
+  // Change the registration status after delay ms. Reported as +CREG URC if enabled with AT+CREG=1 and urc
+  // is set, else only in the response to AT+CREG?.
+  void set_registration(uint8_t stat, uint32_t delay = 0, bool urc = true);
+  // The server sends data on the open socket, or closes it.
+  void socket_server_send(const std::string &data, uint32_t delay = 0);
+  void socket_server_close(uint32_t delay = 0);
+  // Level of the DTR pin, driven by the ESP.
+  void set_dtr(bool high);
+
+  // Commands received since power on, without AT. Combined commands are listed one by one.
+  const std::vector<std::string> &commands() const { return this->commands_; }
+  // Number of received commands starting with prefix.
+  size_t count(const std::string &prefix) const;
+  void clear_commands() { this->commands_.clear(); }
+  // Baud rate the module currently uses, 0 if it did not detect one yet.
+  uint32_t module_baud_rate() const;
+  bool is_asleep() const;
+  bool is_bearer_open() const { return this->bearer_open_; }
+  bool is_http_initialized() const { return this->http_initialized_; }
+  bool is_socket_connected() const { return this->socket_connected_; }
+  // Bytes lost because the UART driver buffer was full, or because the baud rates did not match.
+  uint32_t get_overrun_bytes() const { return this->overrun_bytes_; }
+  uint32_t get_garbled_bytes() const { return this->garbled_bytes_; }
+  uint64_t get_bytes_sent() const { return this->bytes_sent_; }
+  // Time in us when the next scheduled output or event is due, or UINT64_MAX if none.
+  uint64_t next_event_us() const;
+
+ protected:
+  struct Event {
+    uint64_t at_us;
+    uint64_t order;
+    std::function<void()> action;
+  };
+  struct WireByte {
+    uint64_t at_ns;
+    uint32_t baud_rate;
+    uint8_t data;
+  };
+  struct Reply {
+    std::string lines;
+    // OK, ERROR, SHUT OK, ... Empty if the command completes on its own later.
+    std::string result;
+    uint32_t latency;
+  };
+
+  // Run the events that are due and move received bytes into the driver buffer.
+  void update_();
+  // The host time, or the scheduled time of the event that is running.
+  uint64_t now_() const;
+  void schedule_(uint32_t delay, std::function<void()> action);
+  // Send text to the ESP after delay ms.
+  void emit_(const std::string &text, uint32_t delay);
+  void emit_line_(const std::string &line, uint32_t delay) { this->emit_("\r\n" + line + "\r\n", delay); }
+  void handle_line_(const std::string &line);
+  // Handle one command. Appends its response lines to reply.lines and sets reply.result.
+  void handle_command_(const std::string &command, Reply &reply);
+  void handle_data_(const std::string &data);
+  bool take_fault_(std::map<std::string, uint32_t> &faults, const std::string &command);
+  // The latency set for command, or latency if none was set.
+  uint32_t latency_of_(const std::string &command, uint32_t latency) const;
+  // Whether the module is able to receive the line: started, awake and at the same baud rate.
+  bool accepts_input_(const std::string &line);
+  // Register to the network once the SIM is ready and the registration time has passed.
+  void update_registration_();
+  void socket_received_(const std::string &data);
+
+  std::vector<Event> events_;
+  uint64_t event_order_{0};
+  bool in_event_{false};
+  uint64_t event_us_{0};
+  std::deque<WireByte> wire_;
+  uint64_t wire_free_ns_{0};
+  std::deque<uint8_t> fifo_;
+
+  std::map<std::string, uint32_t> latencies_;
+  std::map<std::string, uint32_t> errors_;
+  std::map<std::string, uint32_t> drops_;
+  std::vector<std::string> commands_;
+
+  uint64_t boot_at_us_{0};
+  uint64_t last_input_us_{0};
+  uint32_t detected_baud_rate_{0};
+  uint32_t ipr_{0};
+  bool echo_{true};
+  uint8_t csclk_{0};
+  bool dtr_high_{false};
+  uint64_t dtr_low_at_us_{0};
+  std::string line_;
+  bool after_command_{false};
+  // Bytes still expected after DOWNLOAD or >, and the command that expects them
+  uint32_t data_remaining_{0};
+  std::string data_command_;
+  std::string data_;
+
+  bool sim_ready_{false};
+  bool pin_locked_{false};
+  bool creg_urc_{false};
+  uint8_t registration_{2};
+  bool registration_due_{false};
+  bool bearer_open_{false};
+  bool http_initialized_{false};
+  std::string http_url_;
+  std::string http_data_;
+  bool http_has_response_{false};
+  std::string http_response_;
+  bool ip_started_{false};
+  bool socket_connected_{false};
+  std::string socket_rx_;
+
+  uint32_t overrun_bytes_{0};
+  uint32_t garbled_bytes_{0};
+  uint64_t bytes_sent_{0};
+};
+
+}  // namespace testing
+}  // namespace sim800l_data
+}  // namespace esphome
@@ -0,0 +1,17 @@
+#pragma once
+
+namespace esphome {
+namespace sensor {
+
+class Sensor {
+ public:
+  void publish_state(float state) {
+    this->state = state;
+    this->has_state = true;
+  }
+  float state{0.0f};
+  bool has_state{false};
+};
+
+}  // namespace sensor
+}  // namespace esphome
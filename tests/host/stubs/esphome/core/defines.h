@@ -0,0 +1,4 @@
+#pragma once
+
+// Host build: sensors are enabled so their code is built and tested, no ESP platform is defined.
+#define USE_SENSOR
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+
+namespace esphome {
+
+// The host clock only advances when the harness moves it, so runs are reproducible.
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+
+namespace host {
+uint64_t now_us();
+void set_now_us(uint64_t now_us);
+void advance_us(uint64_t us);
+}  // namespace host
+
+class GPIOPin {
+ public:
+  virtual ~GPIOPin() = default;
+  virtual void setup() = 0;
+  virtual void digital_write(bool value) = 0;
+  virtual bool digital_read() = 0;
+};
+
+}  // namespace esphome
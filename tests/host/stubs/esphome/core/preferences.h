@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <vector>
+
+namespace esphome {
+
+// In-memory preferences. Saved data lives as long as the process, so a test can
+// create a new component to simulate a reboot.
+class ESPPreferenceObject {
+ public:
+  ESPPreferenceObject() = default;
+  ESPPreferenceObject(uint32_t key, size_t size) : key_(key), size_(size), valid_(true) {}
+
+  template<typename T> bool save(const T *src) { return this->save_(reinterpret_cast<const uint8_t *>(src), sizeof(T)); }
+  template<typename T> bool load(T *dest) { return this->load_(reinterpret_cast<uint8_t *>(dest), sizeof(T)); }
+
+ protected:
+  bool save_(const uint8_t *data, size_t length);
+  bool load_(uint8_t *data, size_t length);
+
+  uint32_t key_{0};
+  size_t size_{0};
+  bool valid_{false};
+};
+
+class ESPPreferences {
+ public:
+  template<typename T> ESPPreferenceObject make_preference(uint32_t type, bool in_flash) {
+    return this->make_(type, sizeof(T), in_flash);
+  }
+  // Like on the ESP8266, preferences are in RTC memory unless in_flash is set.
+  template<typename T> ESPPreferenceObject make_preference(uint32_t type) { return this->make_(type, sizeof(T), false); }
+  bool sync() { return true; }
+
+  // Host only: stored data and the in_flash flag of each key, and saves to make fail.
+  std::map<uint32_t, std::vector<uint8_t>> data;
+  std::map<uint32_t, bool> in_flash;
+  uint32_t saves{0};
+  bool fail_saves{false};
+  void clear() {
+    this->data.clear();
+    this->in_flash.clear();
+    this->saves = 0;
+    this->fail_saves = false;
+  }
+
+ protected:
+  ESPPreferenceObject make_(uint32_t type, size_t size, bool in_flash);
+};
+
+extern ESPPreferences *global_preferences;
+
+}  // namespace esphome
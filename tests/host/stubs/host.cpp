@@ -0,0 +1,82 @@
+#include "esphome/core/hal.h"
+#include "esphome/core/helpers.h"
+#include "esphome/core/log.h"
+#include "esphome/core/preferences.h"
+
+#include <cstdio>
+
+namespace esphome {
+
+namespace host {
+
+static uint64_t clock_us = 0;
+
+uint64_t now_us() { return clock_us; }
+void set_now_us(uint64_t now_us) { clock_us = now_us; }
+void advance_us(uint64_t us) { clock_us += us; }
+
+int log_level = [] {
+  const char *level = getenv("SIM800L_LOG_LEVEL");
+  return level == nullptr ? ESPHOME_LOG_LEVEL_NONE : atoi(level);
+}();
+unsigned log_counts[ESPHOME_LOG_LEVEL_VERY_VERBOSE + 1];
+
+void reset_log_counts() { memset(log_counts, 0, sizeof(log_counts)); }
+
+void log(int level, const char *tag, const char *format, ...) {
+  log_counts[level]++;
+  if (level > log_level) {
+    return;
+  }
+  static const char LETTERS[] = "-EWICDVX";
+  printf("[%8.3f][%c][%s] ", clock_us / 1000000.0, LETTERS[level], tag);
+  va_list args;
+  va_start(args, format);
+  vprintf(format, args);
+  va_end(args);
+  printf("\n");
+}
+
+}  // namespace host
+
+uint32_t millis() { return static_cast<uint32_t>(host::clock_us / 1000); }
+uint32_t micros() { return static_cast<uint32_t>(host::clock_us); }
+void delay(uint32_t ms) { host::clock_us += ms * 1000ULL; }
+void delayMicroseconds(uint32_t us) { host::clock_us += us; }
+
+uint32_t fnv1_hash(const std::string &str) {
+  uint32_t hash = 2166136261UL;
+  for (char c : str) {
+    hash *= 16777619UL;
+    hash ^= static_cast<uint8_t>(c);
+  }
+  return hash;
+}
+
+static ESPPreferences preferences;
+ESPPreferences *global_preferences = &preferences;
+
+ESPPreferenceObject ESPPreferences::make_(uint32_t type, size_t size, bool in_flash) {
+  this->in_flash[type] = in_flash;
+  return ESPPreferenceObject(type, size);
+}
+
+bool ESPPreferenceObject::save_(const uint8_t *data, size_t length) {
+  if (!this->valid_ || length != this->size_ || global_preferences->fail_saves) {
+    return false;
+  }
+  global_preferences->saves++;
+  global_preferences->data[this->key_].assign(data, data + length);
+  return true;
+}
+
+bool ESPPreferenceObject::load_(uint8_t *data, size_t length) {
+  auto it = global_preferences->data.find(this->key_);
+  if (!this->valid_ || it == global_preferences->data.end() || it->second.size() != length) {
+    return false;
+  }
+  memcpy(data, it->second.data(), length);
+  return true;
+}
+
+}  // namespace esphome
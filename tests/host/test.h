@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Minimal test runner. A test fails at its first failed CHECK.
+namespace esphome {
+namespace sim800l_data {
+namespace testing {
+
+struct TestCase {
+  const char *name;
+  void (*function)();
+};
+
+std::vector<TestCase> &test_cases();
+// Record a failure of the running test.
+void test_failed(const char *file, int line, const std::string &message);
+
+struct TestRegistration {
+  TestRegistration(const char *name, void (*function)()) { test_cases().push_back({name, function}); }
+};
+
+template<typename A, typename B> std::string describe_mismatch(const A &a, const B &b) {
+  std::ostringstream out;
+  out << a << " != " << b;
+  return out.str();
+}
+
+}  // namespace testing
+}  // namespace sim800l_data
+}  // namespace esphome
+
+#define TEST(name) \
+  static void name(); \
+  static const esphome::sim800l_data::testing::TestRegistration name##_registration(#name, name); \
+  static void name()
+
+#define CHECK(condition) \
+  do { \
+    if (!(condition)) { \
+      esphome::sim800l_data::testing::test_failed(__FILE__, __LINE__, #condition); \
+      return; \
+    } \
+  } while (0)
+
+#define CHECK_EQ(actual, expected) \
+  do { \
+    const auto &actual_ = (actual); \
+    const auto &expected_ = (expected); \
+    if (!(actual_ == expected_)) { \
+      esphome::sim800l_data::testing::test_failed( \
+          __FILE__, __LINE__, \
+          #actual " == " #expected ": " + esphome::sim800l_data::testing::describe_mismatch(actual_, expected_)); \
+      return; \
+    } \
+  } while (0)
@@ -0,0 +1,182 @@
+#include "harness.h"
+#include "test.h"
+
+namespace esphome {
+namespace sim800l_data {
+namespace testing {
+
+TEST(boots_to_idle) {
+  Harness h;
+  h.modem.config.boot_time = 3000;
+  h.modem.config.sim_ready_time = 4000;
+  h.modem.config.registration_time = 6000;
+  h.setup();
+  CHECK(h.boot());
+  // The URCs end the waits, so initialization finishes right after the registration
+  CHECK(millis() < 6500);
+  CHECK(h.component.registered());
+  CHECK_EQ(h.modem.module_baud_rate(), 9600u);
+  CHECK_EQ(h.modem.count("+SAPBR=3,1,\"APN\""), 1u);
+  CHECK_EQ(h.modem.count("+CREG=1"), 1u);
+}
+
+TEST(sync_timeouts_are_not_errors) {
+  Harness h;
+  h.modem.config.boot_time = 3000;
+  h.setup();
+  CHECK(h.boot());
+  // The module does not answer while it starts, which is expected
+  CHECK(h.component.command_stats(CommandId::AT_SYNC).timeouts > 0);
+  CHECK_EQ(host::log_counts[ESPHOME_LOG_LEVEL_ERROR], 0u);
+}
+
+TEST(enters_sim_pin) {
+  Harness h;
+  h.modem.config.pin = "1234";
+  h.modem.config.sim_ready_time = 1000;
+  h.modem.config.registration_time = 2000;
+  h.component.set_pin("1234");
+  h.setup();
+  CHECK(h.boot());
+  CHECK_EQ(h.modem.count("+CPIN=\"1234\""), 1u);
+}
+
+TEST(polls_pin_after_sim_ready_urc) {
+  Harness h;
+  h.modem.config.fixed_baud_rate = 9600;
+  h.modem.config.boot_time = 1000;
+  h.modem.config.sim_ready_time = 1000;
+  h.modem.fail_next("+CPIN?", 3);
+  h.setup();
+  CHECK(h.boot());
+  // Call Ready ends one wait only, the next checks are polled
+  CHECK_EQ(h.modem.count("+CPIN?"), 4u);
+  CHECK(millis() >= 1000 + 2 * SIM_READY_POLL_INTERVAL);
+}
+
+TEST(stops_on_wrong_pin) {
+  Harness h;
+  h.modem.config.pin = "1234";
+  h.component.set_pin("0000");
+  h.setup();
+  CHECK(h.run_until_state(State::FATAL, 10000));
+  // Only one attempt, the SIM is locked with PUK after three
+  h.run_for(20000);
+  CHECK_EQ(h.modem.count("+CPIN=\""), 1u);
+}
+
+TEST(retries_lost_response) {
+  Harness h;
+  h.modem.drop_next("+CBC");
+  h.setup();
+  CHECK(h.boot());
+  CHECK_EQ(h.modem.count("+CBC"), 2u);
+  CHECK_EQ(h.component.command_stats(CommandId::CHECK_BATTERY).timeouts, 1u);
+}
+
+TEST(restarts_on_rdy) {
+  Harness h;
+  // With a fixed baud rate the module sends RDY when it has started, and ignores commands before
+  h.modem.config.fixed_baud_rate = 9600;
+  h.modem.config.boot_time = 1000;
+  h.setup();
+  CHECK(h.boot());
+  h.modem.power_on();
+  CHECK(h.run_until([&h]() { return !h.component.initialized(); }, 3000));
+  CHECK(h.boot());
+}
+
+TEST(switches_baud_rate_after_sync) {
+  Harness h;
+  h.component.set_target_baud_rate(460800);
+  h.modem.config.boot_time = 3000;
+  h.setup();
+  // The module does not answer while it starts. Both rates are probed with AT, but the module
+  // is only switched after it answered.
+  h.run_for(3000);
+  CHECK_EQ(h.modem.count("+IPR"), 0u);
+  CHECK(h.boot());
+  CHECK_EQ(h.modem.get_baud_rate(), 460800u);
+  CHECK_EQ(h.modem.module_baud_rate(), 460800u);
+  CHECK_EQ(h.modem.count("+IPR=460800"), 1u);
+}
+
+TEST(finds_module_at_target_baud_rate_after_esp_restart) {
+  Harness h;
+  h.component.set_target_baud_rate(115200);
+  // The module was switched before the ESP restarted and is still running at the target rate
+  h.modem.config.fixed_baud_rate = 115200;
+  h.setup();
+  CHECK(h.boot());
+  CHECK_EQ(h.modem.get_baud_rate(), 115200u);
+  CHECK_EQ(h.modem.count("+IPR"), 0u);
+}
+
+TEST(returns_to_initial_baud_rate_after_module_restart) {
+  Harness h;
+  h.component.set_target_baud_rate(460800);
+  h.component.set_battery_check_interval(10000);
+  h.setup();
+  CHECK(h.boot());
+  // The restarted module autobauds at the initial rate again. The next status check fails, and the
+  // module is switched once more.
+  h.modem.power_on();
+  CHECK(h.run_until([&h]() { return h.modem.get_baud_rate() == 9600; }, 30000));
+  CHECK(h.boot());
+  CHECK_EQ(h.modem.get_baud_rate(), 460800u);
+  CHECK_EQ(h.modem.module_baud_rate(), 460800u);
+  CHECK_EQ(h.modem.count("+IPR=460800"), 1u);
+}
+
+TEST(checks_status_from_idle) {
+  Harness h;
+  h.component.set_battery_check_interval(10000);
+  h.component.set_signal_check_interval(10000);
+  h.setup();
+  CHECK(h.boot());
+  h.modem.clear_commands();
+  h.run_for(10500);
+  // Each check runs once per interval, without the rest of the initialization
+  CHECK_EQ(h.modem.count("+CBC"), 1u);
+  CHECK_EQ(h.modem.count("+CSQ"), 1u);
+  CHECK_EQ(h.modem.count("+CPIN?"), 0u);
+  CHECK_EQ(h.component.state(), State::IDLE);
+}
+
+TEST(waits_for_registration_after_failed_status_check) {
+  Harness h;
+  h.component.set_registration_check_interval(10000);
+  h.setup();
+  CHECK(h.boot());
+  h.modem.clear_commands();
+  // Without a URC, the lost registration is noticed by the next status check
+  h.modem.set_registration(0, 0, false);
+  CHECK(h.run_until_state(State::WAIT_REGISTRATION, 15000));
+  CHECK(!h.component.registered());
+  h.modem.set_registration(1, 5000, false);
+  CHECK(h.run_until([&h]() { return h.component.registered(); }, REGISTRATION_POLL_INTERVAL + 1000));
+  CHECK(h.run_until_state(State::IDLE, 1000));
+  // Polled until registered, without initializing the module again
+  CHECK_EQ(h.modem.count("+CREG?"), 2u);
+  CHECK_EQ(h.modem.count("E0"), 0u);
+  CHECK_EQ(h.modem.count("+CREG=1"), 0u);
+}
+
+TEST(waits_for_registration_after_urc) {
+  Harness h;
+  h.setup();
+  CHECK(h.boot());
+  h.modem.clear_commands();
+  h.modem.set_registration(0);
+  CHECK(h.run_until_state(State::WAIT_REGISTRATION, 1000));
+  // The URC of the new registration ends the wait before the next poll
+  h.modem.set_registration(1, 3000);
+  CHECK(h.run_until_state(State::IDLE, 5000));
+  CHECK(h.component.registered());
+  CHECK_EQ(h.modem.count("+CREG?"), 0u);
+  CHECK_EQ(h.modem.count("E0"), 0u);
+}
+
+}  // namespace testing
+}  // namespace sim800l_data
+}  // namespace esphome
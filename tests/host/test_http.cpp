@@ -0,0 +1,273 @@
+#include "harness.h"
+#include "test.h"
+
+namespace esphome {
+namespace sim800l_data {
+namespace testing {
+
+TEST(http_get_full_transaction) {
+  Harness h;
+  h.modem.http_handler = [](const std::string &method, const std::string &url, const std::string &body) {
+    return Sim800lEmulator::HttpResponse{200, method + " " + url};
+  };
+  h.setup();
+  CHECK(h.boot());
+  uint16_t status = 0;
+  std::string response;
+  h.component.http_get("http://example.com/a", [&](uint16_t status_code, std::string &body) {
+    status = status_code;
+    response = body;
+  });
+  CHECK(h.run_until_idle(30000));
+  CHECK_EQ(status, 200);
+  CHECK_EQ(response, std::string("GET http://example.com/a"));
+  // The bearer and HTTP session are closed again
+  CHECK(!h.modem.is_bearer_open());
+  CHECK(!h.modem.is_http_initialized());
+  CHECK_EQ(h.modem.count("+HTTPTERM"), 1u);
+}
+
+TEST(http_requests_share_bearer) {
+  Harness h;
+  h.setup();
+  CHECK(h.boot());
+  int done = 0;
+  h.component.add_on_http_request_done_callback([&done](uint16_t status_code, std::string &body) { done++; });
+  h.component.http_get("http://example.com/a");
+  h.component.http_get("http://example.com/b");
+  h.component.http_get("http://example.com/c");
+  CHECK(h.run_until_idle(30000));
+  CHECK_EQ(done, 3);
+  CHECK_EQ(h.modem.count("+SAPBR=1,1"), 1u);
+  CHECK_EQ(h.modem.count("+HTTPACTION=0"), 3u);
+}
+
+TEST(http_keeps_bearer_open) {
+  Harness h;
+  h.component.set_keep_bearer_open(5000);
+  h.setup();
+  CHECK(h.boot());
+  h.component.http_get("http://example.com/a");
+  CHECK(h.run_until_idle(30000));
+  CHECK(h.modem.is_bearer_open());
+  h.component.http_get("http://example.com/b");
+  CHECK(h.run_until_idle(30000));
+  // The open bearer is only checked, then closed once it was idle for long enough
+  CHECK_EQ(h.modem.count("+SAPBR=1,1"), 1u);
+  CHECK_EQ(h.modem.count("+SAPBR=2,1"), 1u);
+  h.run_for(6000);
+  CHECK(!h.modem.is_bearer_open());
+}
+
+TEST(http_waits_for_slow_response) {
+  Harness h;
+  h.setup();
+  CHECK(h.boot());
+  // Longer than the timeout of the OK, but within the URC timeout
+  h.modem.set_latency("+HTTPACTION:", 20000);
+  uint16_t status = 0;
+  h.component.http_get("http://example.com/slow", [&status](uint16_t status_code, std::string &body) {
+    status = status_code;
+  });
+  CHECK(h.run_until_idle(60000));
+  CHECK_EQ(status, 200);
+}
+
+TEST(http_post_body) {
+  Harness h;
+  std::string posted;
+  h.modem.http_handler = [&posted](const std::string &method, const std::string &url, const std::string &body) {
+    posted = body;
+    return Sim800lEmulator::HttpResponse{201, ""};
+  };
+  h.setup();
+  CHECK(h.boot());
+  const std::string body(1000, 'x');
+  uint16_t status = 0;
+  h.component.add_on_http_request_done_callback([&status](uint16_t status_code, std::string &body) {
+    status = status_code;
+  });
+  h.component.http_post("http://example.com/post", "text/plain", body);
+  CHECK(h.run_until_idle(30000));
+  CHECK_EQ(status, 201);
+  CHECK(posted == body);
+  CHECK_EQ(h.modem.count("+HTTPREAD"), 0u);
+}
+
+TEST(http_post_provider_fails_partway) {
+  Harness h;
+  int posts = 0;
+  h.modem.http_handler = [&posts](const std::string &method, const std::string &url, const std::string &body) {
+    posts += method == "POST";
+    return Sim800lEmulator::HttpResponse{200, "ok"};
+  };
+  h.setup();
+  CHECK(h.boot());
+  std::vector<uint16_t> statuses;
+  h.component.add_on_http_request_done_callback([&statuses](uint16_t status_code, std::string &body) {
+    statuses.push_back(status_code);
+  });
+  int failed = 0;
+  h.component.add_on_http_request_failed_callback([&failed]() { failed++; });
+  // The provider gives up after 300 of 1000 bytes
+  h.component.http_post("http://example.com/post", "text/plain", 1000,
+                        [](uint32_t offset, uint8_t *buffer, size_t length) -> size_t {
+                          if (offset >= 300) {
+                            return 0;
+                          }
+                          memset(buffer, 'x', length);
+                          return length;
+                        });
+  h.component.http_get("http://example.com/a");
+  CHECK(h.run_until_idle(30000));
+  // The module gets the whole body length before the next command, the POST is not sent
+  CHECK_EQ(failed, 1);
+  CHECK_EQ(posts, 0);
+  CHECK_EQ(statuses.size(), 1u);
+  CHECK_EQ(statuses[0], 200);
+  CHECK_EQ(h.modem.count("+HTTPTERM"), 1u);
+}
+
+TEST(http_failure_calls_callbacks) {
+  Harness h;
+  h.setup();
+  CHECK(h.boot());
+  h.modem.fail_next("+SAPBR=1,1");
+  int failed = 0;
+  int status = -1;
+  h.component.add_on_http_request_failed_callback([&failed]() { failed++; });
+  h.component.http_get("http://example.com/a", [&status](uint16_t status_code, std::string &body) {
+    status = status_code;
+  });
+  CHECK(h.run_until_idle(30000));
+  CHECK_EQ(failed, 1);
+  CHECK_EQ(status, 0);
+}
+
+TEST(http_streams_response) {
+  Harness h;
+  h.component.set_stream_response(true);
+  h.component.set_response_chunk_size(100);
+  h.modem.http_handler = [](const std::string &method, const std::string &url, const std::string &body) {
+    return Sim800lEmulator::HttpResponse{200, std::string(250, 'y')};
+  };
+  h.setup();
+  CHECK(h.boot());
+  std::vector<uint32_t> offsets;
+  size_t received = 0;
+  h.component.add_on_http_response_chunk_callback([&](uint32_t offset, std::string &chunk) {
+    offsets.push_back(offset);
+    received += chunk.size();
+  });
+  h.component.http_get("http://example.com/big");
+  CHECK(h.run_until_idle(30000));
+  CHECK_EQ(received, 250u);
+  CHECK_EQ(offsets.size(), 3u);
+  CHECK_EQ(offsets[2], 200u);
+}
+
+TEST(http_coalesces_queued_gets) {
+  Harness h;
+  h.component.set_http_coalesce(HttpCoalesce::MERGE_QUERY);
+  std::vector<std::string> urls;
+  h.modem.http_handler = [&urls](const std::string &method, const std::string &url, const std::string &body) {
+    urls.push_back(url);
+    return Sim800lEmulator::HttpResponse{200, ""};
+  };
+  h.setup();
+  CHECK(h.boot());
+  int calls = 0;
+  h.component.http_get("http://example.com/s?a=1", [&calls](uint16_t status_code, std::string &body) { calls++; });
+  h.component.http_get("http://example.com/s?b=2", [&calls](uint16_t status_code, std::string &body) { calls++; });
+  CHECK(h.run_until_idle(30000));
+  CHECK_EQ(urls.size(), 1u);
+  CHECK_EQ(urls[0], std::string("http://example.com/s?a=1&b=2"));
+  CHECK_EQ(calls, 2);
+}
+
+// HTTP server on the socket: answers each GET written to it with its path
+std::string answer_gets(const std::string &data) {
+  std::string response;
+  for (size_t pos = data.find("GET "); pos != std::string::npos; pos = data.find("GET ", pos + 1)) {
+    const std::string path = data.substr(pos + 4, data.find(' ', pos + 4) - pos - 4);
+    response += "HTTP/1.1 200 OK\r\nContent-Length: " + std::to_string(path.size()) + "\r\n\r\n" + path;
+  }
+  return response;
+}
+
+TEST(http_min_interval_defers_only_its_endpoint) {
+  Harness h;
+  h.component.set_http_min_interval(20000);
+  h.setup();
+  CHECK(h.boot());
+  std::vector<std::string> urls;
+  h.modem.http_handler = [&urls](const std::string &method, const std::string &url, const std::string &body) {
+    urls.push_back(url);
+    return Sim800lEmulator::HttpResponse{200, "ok"};
+  };
+  const uint32_t start = millis();
+  h.component.http_get("http://example.com/a?1");
+  h.component.http_get("http://example.com/a?2");
+  h.component.http_get("http://example.com/b");
+  // The second request to /a waits, /b is sent right after the first one
+  CHECK(h.run_until([&urls]() { return urls.size() == 2; }, 10000));
+  CHECK_EQ(urls[1], std::string("http://example.com/b"));
+  CHECK(millis() - start < 10000);
+  CHECK(h.run_until_idle(30000));
+  CHECK_EQ(urls.size(), 3u);
+  CHECK(millis() - start >= 20000);
+  // All three over one bearer, which is closed once the queue is empty
+  CHECK_EQ(h.modem.count("+SAPBR=1,1"), 1u);
+  CHECK(!h.modem.is_bearer_open());
+}
+
+TEST(http_keep_alive_fails_only_oversized_request) {
+  Harness h;
+  h.component.set_http_keep_alive(true);
+  h.modem.socket_handler = answer_gets;
+  h.setup();
+  CHECK(h.boot());
+  std::vector<std::string> responses;
+  auto callback = [&responses](uint16_t status_code, std::string &body) {
+    responses.push_back(std::to_string(status_code) + " " + body.substr(0, 8));
+  };
+  h.component.http_get("http://example.com/a", callback);
+  // Does not fit into one AT+CIPSEND, while /a is still waiting for its response
+  h.component.http_get("http://example.com/" + std::string(SOCKET_MAX_SEND_SIZE, 'x'), callback);
+  h.component.http_get("http://example.com/c", callback);
+  CHECK(h.run_until_idle(30000));
+  CHECK_EQ(responses.size(), 3u);
+  CHECK_EQ(responses[0], std::string("0 "));
+  CHECK_EQ(responses[1], std::string("200 /a"));
+  CHECK_EQ(responses[2], std::string("200 /c"));
+}
+
+TEST(http_keep_alive_socket_rejects_user_calls) {
+  Harness h;
+  h.component.set_http_keep_alive(true);
+  h.component.set_keep_bearer_open(5000);
+  h.modem.socket_handler = answer_gets;
+  h.setup();
+  CHECK(h.boot());
+  uint16_t status = 0;
+  h.component.http_get("http://example.com/a", [&status](uint16_t status_code, std::string &body) {
+    status = status_code;
+  });
+  CHECK(h.run_until_idle(30000));
+  CHECK_EQ(status, 200);
+  CHECK(h.component.socket_keep_alive());
+  CHECK(h.modem.is_socket_connected());
+  const size_t sends = h.modem.count("+CIPSEND");
+  CHECK(!h.component.socket_send("data"));
+  CHECK(!h.component.socket_close());
+  h.run_for(1000);
+  CHECK(h.modem.is_socket_connected());
+  CHECK_EQ(h.modem.count("+CIPSEND"), sends);
+  // The idle keep-alive connection is still closed by the component
+  h.run_for(5000);
+  CHECK(!h.modem.is_socket_connected());
+}
+
+}  // namespace testing
+}  // namespace sim800l_data
+}  // namespace esphome
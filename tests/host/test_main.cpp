@@ -0,0 +1,46 @@
+#include <cstring>
+
+#include "test.h"
+
+namespace esphome {
+namespace sim800l_data {
+namespace testing {
+
+static bool current_failed = false;
+
+std::vector<TestCase> &test_cases() {
+  static std::vector<TestCase> cases;
+  return cases;
+}
+
+void test_failed(const char *file, int line, const std::string &message) {
+  printf("%s:%d: check failed: %s\n", file, line, message.c_str());
+  current_failed = true;
+}
+
+}  // namespace testing
+}  // namespace sim800l_data
+}  // namespace esphome
+
+// Runs all tests, or the tests whose names are given as arguments.
+int main(int argc, char **argv) {
+  using namespace esphome::sim800l_data::testing;
+  int failed = 0;
+  int run = 0;
+  for (const TestCase &test : test_cases()) {
+    bool selected = argc < 2;
+    for (int i = 1; i < argc; i++) {
+      selected |= strcmp(argv[i], test.name) == 0;
+    }
+    if (!selected) {
+      continue;
+    }
+    current_failed = false;
+    test.function();
+    run++;
+    printf("%s %s\n", current_failed ? "FAIL" : "PASS", test.name);
+    failed += current_failed;
+  }
+  printf("%d of %d tests passed\n", run - failed, run);
+  return failed == 0 && run > 0 ? 0 : 1;
+}
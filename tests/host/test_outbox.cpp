@@ -0,0 +1,96 @@
+#include "esphome/core/preferences.h"
+
+#include "harness.h"
+#include "test.h"
+
+namespace esphome {
+namespace sim800l_data {
+namespace testing {
+
+TEST(outbox_sends_entries_in_one_post) {
+  Harness h;
+  h.component.set_outbox("http://example.com/outbox", "text/plain", 4);
+  std::vector<std::string> bodies;
+  h.modem.http_handler = [&bodies](const std::string &method, const std::string &url, const std::string &body) {
+    bodies.push_back(body);
+    return Sim800lEmulator::HttpResponse{200, ""};
+  };
+  h.setup();
+  CHECK(h.component.outbox_add("first"));
+  CHECK(h.component.outbox_add(std::string(OUTBOX_ENTRY_SIZE, 'x')));
+  CHECK(h.component.outbox_add("third"));
+  CHECK(h.boot());
+  CHECK(h.run_until([&h]() { return h.component.get_outbox_depth() == 0; }, 30000));
+  CHECK_EQ(bodies.size(), 1u);
+  CHECK_EQ(bodies[0], "first\n" + std::string(OUTBOX_ENTRY_SIZE, 'x') + "\nthird");
+}
+
+TEST(outbox_keeps_entries_across_reboot) {
+  {
+    Harness h;
+    h.component.set_outbox("http://example.com/outbox", "text/plain", 4);
+    h.setup();
+    CHECK(h.component.outbox_add("a"));
+    CHECK(h.component.outbox_add("b"));
+  }
+  Harness h(9600, true);
+  h.component.set_outbox("http://example.com/outbox", "text/plain", 4);
+  std::string sent;
+  h.modem.http_handler = [&sent](const std::string &method, const std::string &url, const std::string &body) {
+    sent = body;
+    return Sim800lEmulator::HttpResponse{200, ""};
+  };
+  h.setup();
+  CHECK_EQ(h.component.get_outbox_depth(), 2u);
+  CHECK(h.boot());
+  CHECK(h.run_until([&h]() { return h.component.get_outbox_depth() == 0; }, 30000));
+  CHECK_EQ(sent, std::string("a\nb"));
+}
+
+TEST(outbox_add_fails_when_not_saved) {
+  Harness h;
+  h.component.set_outbox("http://example.com/outbox", "text/plain", 2);
+  h.setup();
+  CHECK(h.component.outbox_add("a"));
+  CHECK(h.component.outbox_add("b"));
+  global_preferences->fail_saves = true;
+  // The outbox is full, a failed save must not drop the oldest entry
+  CHECK(!h.component.outbox_add("c"));
+  CHECK_EQ(h.component.get_outbox_depth(), 2u);
+  CHECK(!h.component.outbox_add(std::string(OUTBOX_ENTRY_SIZE + 1, 'x')));
+  global_preferences->fail_saves = false;
+  std::string sent;
+  h.modem.http_handler = [&sent](const std::string &method, const std::string &url, const std::string &body) {
+    sent = body;
+    return Sim800lEmulator::HttpResponse{200, ""};
+  };
+  CHECK(h.boot());
+  CHECK(h.run_until([&h]() { return h.component.get_outbox_depth() == 0; }, 30000));
+  CHECK_EQ(sent, std::string("a\nb"));
+}
+
+TEST(outbox_entry_overwritten_while_sending) {
+  Harness h;
+  h.component.set_outbox("http://example.com/outbox", "text/plain", 2);
+  std::vector<std::string> bodies;
+  h.modem.http_handler = [&bodies](const std::string &method, const std::string &url, const std::string &body) {
+    bodies.push_back(body);
+    return Sim800lEmulator::HttpResponse{200, ""};
+  };
+  h.setup();
+  CHECK(h.component.outbox_add("aaa"));
+  CHECK(h.component.outbox_add("bbb"));
+  CHECK(h.boot());
+  // The flush is queued, then the oldest entry is overwritten before the body is sent
+  CHECK(h.run_until([&h]() { return h.component.get_http_queue_depth() > 0; }, 30000));
+  CHECK(h.component.outbox_add("ccc"));
+  CHECK(h.run_until([&h]() { return h.component.get_outbox_depth() == 0; }, 30000));
+  // The body keeps its size, the lost entry is sent as spaces. The new entry is sent next.
+  CHECK_EQ(bodies.size(), 2u);
+  CHECK_EQ(bodies[0], std::string("   \nbbb"));
+  CHECK_EQ(bodies[1], std::string("ccc"));
+}
+
+}  // namespace testing
+}  // namespace sim800l_data
+}  // namespace esphome
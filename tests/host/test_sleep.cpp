@@ -0,0 +1,91 @@
+#include "harness.h"
+#include "test.h"
+
+namespace esphome {
+namespace sim800l_data {
+namespace testing {
+
+// Sum of the timeouts of all commands, a command sent to the sleeping module times out
+uint32_t total_timeouts(const TestComponent &component) {
+  uint32_t timeouts = 0;
+  for (size_t i = 0; i < static_cast<size_t>(CommandId::COUNT); i++) {
+    timeouts += component.command_stats(static_cast<CommandId>(i)).timeouts;
+  }
+  return timeouts;
+}
+
+TEST(dtr_sleep_and_wake) {
+  Harness h;
+  MockPin pin(&h.modem);
+  h.component.set_idle_sleep(true);
+  h.component.set_dtr_pin(&pin);
+  h.setup();
+  CHECK(pin.is_setup);
+  CHECK(!pin.level);
+  CHECK(h.boot());
+  CHECK(h.run_until([&h]() { return h.component.idle_sleep_active(); }, 5000));
+  // +CSCLK=1 is sent, then the module sleeps while DTR is high
+  CHECK_EQ(h.modem.count("+CSCLK=1"), 1u);
+  CHECK_EQ(h.modem.count("+CSCLK=2"), 0u);
+  CHECK(pin.level);
+  h.run_for(100);
+  CHECK(h.modem.is_asleep());
+
+  // A request pulls DTR low and waits for the module to wake before the first command
+  const size_t writes = pin.writes.size();
+  uint16_t status = 0;
+  h.component.http_get("http://example.com/a", [&status](uint16_t status_code, std::string &body) {
+    status = status_code;
+  });
+  CHECK(h.run_until([&pin]() { return !pin.level; }, 1000));
+  CHECK_EQ(pin.writes.size(), writes + 1);
+  CHECK(h.run_until([&status]() { return status != 0; }, 30000));
+  CHECK_EQ(status, 200);
+  CHECK_EQ(total_timeouts(h.component), 0u);
+
+  // Back to sleep with DTR only, +CSCLK=1 is not sent again
+  CHECK(h.run_until([&h]() { return h.component.idle_sleep_active(); }, 5000));
+  CHECK(pin.level);
+  CHECK_EQ(h.modem.count("+CSCLK=1"), 1u);
+  CHECK_EQ(h.modem.count("+CSCLK=0"), 0u);
+}
+
+TEST(dtr_wakes_for_status_checks) {
+  Harness h;
+  MockPin pin(&h.modem);
+  h.component.set_idle_sleep(true);
+  h.component.set_dtr_pin(&pin);
+  h.setup();
+  CHECK(h.boot());
+  CHECK(h.run_until([&h]() { return h.component.idle_sleep_active(); }, 5000));
+  h.modem.clear_commands();
+  // update() requests the periodic checks, which wake the module
+  h.run_for(61000);
+  CHECK(h.modem.count("+CBC") + h.modem.count("+CSQ") > 0);
+  CHECK_EQ(total_timeouts(h.component), 0u);
+  CHECK(h.component.idle_sleep_active());
+  CHECK(pin.level);
+}
+
+TEST(sleep_without_dtr_wakes_with_at) {
+  Harness h;
+  h.component.set_idle_sleep(true);
+  h.setup();
+  CHECK(h.boot());
+  CHECK(h.run_until([&h]() { return h.component.idle_sleep_active(); }, 5000));
+  CHECK_EQ(h.modem.count("+CSCLK=2"), 1u);
+  h.run_for(6000);
+  CHECK(h.modem.is_asleep());
+  uint16_t status = 0;
+  h.component.http_get("http://example.com/a", [&status](uint16_t status_code, std::string &body) {
+    status = status_code;
+  });
+  CHECK(h.run_until([&status]() { return status != 0; }, 30000));
+  CHECK_EQ(status, 200);
+  // The module is woken with AT and sleep is disabled for the request
+  CHECK_EQ(h.modem.count("+CSCLK=0"), 1u);
+}
+
+}  // namespace testing
+}  // namespace sim800l_data
+}  // namespace esphome
@@ -0,0 +1,56 @@
+#include "harness.h"
+#include "test.h"
+
+namespace esphome {
+namespace sim800l_data {
+namespace testing {
+
+TEST(socket_echo) {
+  Harness h;
+  h.modem.socket_handler = [](const std::string &data) { return "echo:" + data; };
+  h.setup();
+  CHECK(h.boot());
+  bool connected = false;
+  bool closed = false;
+  std::string received;
+  h.component.add_on_socket_connected_callback([&connected]() { connected = true; });
+  h.component.add_on_socket_closed_callback([&closed]() { closed = true; });
+  h.component.add_on_socket_data_callback([&received](std::string &data) { received += data; });
+  h.component.socket_connect(SocketProtocol::TCP, "example.com", 1234);
+  CHECK(h.run_until([&connected]() { return connected; }, 10000));
+  CHECK(h.component.socket_send("hello"));
+  CHECK(h.run_until([&received]() { return !received.empty(); }, 10000));
+  CHECK_EQ(received, std::string("echo:hello"));
+  h.component.socket_close();
+  CHECK(h.run_until([&closed]() { return closed; }, 10000));
+  CHECK(!h.modem.is_socket_connected());
+}
+
+TEST(socket_lost_by_server) {
+  Harness h;
+  h.setup();
+  CHECK(h.boot());
+  bool closed = false;
+  h.component.add_on_socket_closed_callback([&closed]() { closed = true; });
+  h.component.socket_connect(SocketProtocol::TCP, "example.com", 1234);
+  CHECK(h.run_until([&h]() { return h.component.is_socket_connected(); }, 10000));
+  h.modem.socket_server_close();
+  CHECK(h.run_until([&closed]() { return closed; }, 10000));
+  CHECK_EQ(h.component.state(), State::IDLE);
+}
+
+TEST(socket_connect_fails) {
+  Harness h;
+  h.modem.config.refuse_connections = true;
+  h.setup();
+  CHECK(h.boot());
+  bool closed = false;
+  h.component.add_on_socket_closed_callback([&closed]() { closed = true; });
+  h.component.socket_connect(SocketProtocol::TCP, "example.com", 1234);
+  CHECK(h.run_until([&closed]() { return closed; }, 10000));
+  CHECK(!h.component.is_socket_connected());
+}
+
+}  // namespace testing
+}  // namespace sim800l_data
+}  // namespace esphome
@@ -0,0 +1,86 @@
+#include "esphome/core/preferences.h"
+
+#include "harness.h"
+#include "test.h"
+
+namespace esphome {
+namespace sim800l_data {
+namespace testing {
+
+const uint32_t TIMEOUTS_KEY = fnv1_hash("sim800l_data_timeouts") + ADAPTIVE_COMMAND_COUNT;
+
+// Open and close the socket until the closed callback was called count times
+void connect_and_close(Harness &h, int count) {
+  int closed = 0;
+  h.component.add_on_socket_closed_callback([&closed]() { closed++; });
+  for (int i = 0; i < count; i++) {
+    h.component.socket_connect(SocketProtocol::TCP, "example.com", 1234);
+    CHECK(h.run_until([&h]() { return h.component.is_socket_connected(); }, 10000));
+    h.component.socket_close();
+    CHECK(h.run_until([&closed, i]() { return closed > i; }, 10000));
+    CHECK(h.run_until_idle(10000));
+  }
+}
+
+TEST(adaptive_timeouts_only_for_slow_commands) {
+  const TimeoutEstimates estimates{};
+  CHECK(estimates.find(CommandId::BEARER_OPEN) != nullptr);
+  CHECK(estimates.find(CommandId::HTTP_ACTION) != nullptr);
+  CHECK(estimates.find(CommandId::SOCKET_SHUT) != nullptr);
+  // Fast commands can't get a timeout below MIN_ADAPTIVE_TIMEOUT, data commands depend on the length
+  CHECK(estimates.find(CommandId::CHECK_BATTERY) == nullptr);
+  CHECK(estimates.find(CommandId::HTTP_READ) == nullptr);
+  CHECK(sizeof(TimeoutEstimates) < 256u);
+}
+
+TEST(adaptive_timeout_limits_final_response) {
+  Harness h;
+  h.component.set_adaptive_timeouts(true);
+  h.setup();
+  CHECK(h.boot());
+  connect_and_close(h, ADAPTIVE_TIMEOUT_MIN_SAMPLES / 2);
+  CHECK(h.component.timeout_estimates().find(CommandId::SOCKET_SHUT)->samples >= ADAPTIVE_TIMEOUT_MIN_SAMPLES);
+
+  // SHUT OK does not arrive in time: it fails after the learned timeout, not after the 65s of the manual
+  h.modem.set_latency("+CIPSHUT", 20000);
+  bool closed = false;
+  h.component.add_on_socket_closed_callback([&closed]() { closed = true; });
+  const uint32_t start = millis();
+  h.component.socket_connect(SocketProtocol::TCP, "example.com", 1234);
+  CHECK(h.run_until([&h]() { return h.component.command_stats(CommandId::SOCKET_SHUT).timeouts > 0; }, 30000));
+  CHECK(millis() - start < 5000);
+}
+
+TEST(timeouts_saved_to_flash_at_most_hourly) {
+  Harness h;
+  h.component.set_adaptive_timeouts(true);
+  h.component.set_persist_timeouts(true);
+  h.setup();
+  CHECK(global_preferences->in_flash[TIMEOUTS_KEY]);
+  CHECK(h.boot());
+  h.component.http_get("http://example.com/a");
+  CHECK(h.run_until_idle(30000));
+  h.run_for(60000);
+  CHECK_EQ(global_preferences->saves, 1u);
+
+  // Changed again, but the last save is less than an hour ago
+  h.component.http_get("http://example.com/b");
+  CHECK(h.run_until_idle(30000));
+  h.step_us = 100000;
+  h.run_for(30 * 60000);
+  CHECK_EQ(global_preferences->saves, 1u);
+  h.run_for(31 * 60000);
+  CHECK_EQ(global_preferences->saves, 2u);
+
+  // Restored after a reboot
+  const uint16_t samples = h.component.timeout_estimates().find(CommandId::HTTP_ACTION)->samples;
+  Harness rebooted(9600, true);
+  rebooted.component.set_adaptive_timeouts(true);
+  rebooted.component.set_persist_timeouts(true);
+  rebooted.setup();
+  CHECK_EQ(rebooted.component.timeout_estimates().find(CommandId::HTTP_ACTION)->samples, samples);
+}
+
+}  // namespace testing
+}  // namespace sim800l_data
+}  // namespace esphome